@@ -0,0 +1,86 @@
+#include "ai_controller.hpp"
+
+#include <cmath>
+
+AiController::AiController(PaddleSide side, float reactionDelay, float error, uint32_t seed)
+    : Side(side), ReactionDelay(reactionDelay), Error(error), rng(seed), timer(0.0f), target(-1.0f)
+{
+}
+
+unsigned int AiController::Decide(const Simulation &match, float deltaTime)
+{
+    const GameObject &paddle = this->Side == PADDLE_LEFT ? match.Paddle1 : match.Paddle2;
+    const BallObject &ball = match.Ball;
+    // The bot only produces inputs, so it can think in floats whatever the rules use
+    glm::vec2 paddlePosition = ToGlm(paddle.Position), paddleSize = ToGlm(paddle.Size);
+    glm::vec2 ballPosition = ToGlm(ball.Position), ballVelocity = ToGlm(ball.Velocity), ballSize = ToGlm(ball.Size);
+    this->timer -= deltaTime;
+    if (this->timer <= 0.0f || this->target < 0.0f)
+    {
+        this->timer = this->ReactionDelay;
+        bool incoming = this->Side == PADDLE_LEFT ? ballVelocity.x < 0.0f : ballVelocity.x > 0.0f;
+        if (incoming)
+        {
+            // Where the ball's left/right edge touches the paddle's inner face
+            float faceX = this->Side == PADDLE_LEFT ? paddlePosition.x + paddleSize.x : paddlePosition.x - ballSize.x;
+            float ballY = PredictInterceptY(ballPosition, ballVelocity, faceX, 0.0f, match.Height - ballSize.y);
+            this->target = ballY + ballSize.y / 2 + this->rng.Range(-this->Error, this->Error);
+        }
+        else
+            this->target = match.Height / 2.0f; // Wait in the middle
+    }
+
+    // Move towards the target, with a dead zone of one step so the paddle doesn't jitter
+    float center = paddlePosition.y + paddleSize.y / 2;
+    float step = ToFloat(PADDLE_VELOCITY) * deltaTime;
+    unsigned int buttons = 0;
+    if (this->target < center - step)
+        buttons = this->Side == PADDLE_LEFT ? INPUT_PADDLE1_UP : INPUT_PADDLE2_UP;
+    else if (this->target > center + step)
+        buttons = this->Side == PADDLE_LEFT ? INPUT_PADDLE1_DOWN : INPUT_PADDLE2_DOWN;
+    return buttons;
+}
+
+float PredictInterceptY(glm::vec2 position, glm::vec2 velocity, float targetX, float minY, float maxY)
+{
+    float range = maxY - minY;
+    if (velocity.x == 0.0f || range <= 0.0f)
+        return position.y;
+    float time = (targetX - position.x) / velocity.x;
+    if (time < 0.0f)
+        return position.y;
+    // Unfold: position on the infinite line, then fold back with period 2 * range
+    float unfolded = position.y + velocity.y * time - minY;
+    float folded = std::fmod(unfolded, 2.0f * range);
+    if (folded < 0.0f)
+        folded += 2.0f * range;
+    if (folded > range)
+        folded = 2.0f * range - folded;
+    return minY + folded;
+}
+
+unsigned int TrackBall(const Simulation &match)
+{
+    unsigned int buttons = 0;
+    float radius = ToFloat(match.Ball.Radius);
+    float ballCenter = ToFloat(match.Ball.Position.y) + radius;
+    float paddle1Center = ToFloat(match.Paddle1.Position.y + match.Paddle1.Size.y / 2);
+    float paddle2Center = ToFloat(match.Paddle2.Position.y + match.Paddle2.Size.y / 2);
+    float ballX = ToFloat(match.Ball.Position.x) + radius;
+    float ballVelocityX = ToFloat(match.Ball.Velocity.x);
+    if (ballVelocityX < 0.0f && ballX < match.Width / 2)
+    {
+        if (ballCenter < paddle1Center - 10.0f)
+            buttons |= INPUT_PADDLE1_UP;
+        else if (ballCenter > paddle1Center + 10.0f)
+            buttons |= INPUT_PADDLE1_DOWN;
+    }
+    else if (ballVelocityX > 0.0f && ballX > match.Width / 2)
+    {
+        if (ballCenter < paddle2Center - 10.0f)
+            buttons |= INPUT_PADDLE2_UP;
+        else if (ballCenter > paddle2Center + 10.0f)
+            buttons |= INPUT_PADDLE2_DOWN;
+    }
+    return buttons;
+}
\ No newline at end of file
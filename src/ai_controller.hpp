@@ -0,0 +1,45 @@
+#ifndef AI_CONTROLLER_H
+#define AI_CONTROLLER_H
+
+#include <glm/glm.hpp>
+
+#include "random.hpp"
+#include "simulation.hpp"
+
+enum PaddleSide
+{
+    PADDLE_LEFT,
+    PADDLE_RIGHT
+};
+
+// Computer player for one paddle. It predicts where the ball will cross the
+// paddle's face in closed form (wall bounces are unfolded, not simulated) and
+// re-plans only every ReactionDelay seconds, aiming Error pixels off at most.
+class AiController
+{
+  public:
+    PaddleSide Side;
+    float ReactionDelay; // Seconds between two looks at the ball
+    float Error;         // Maximum aiming error in pixels
+
+    AiController(PaddleSide side, float reactionDelay = 0.15f, float error = 20.0f, uint32_t seed = 1);
+
+    // Buttons for this controller's paddle for the next tick
+    unsigned int Decide(const Simulation &match, float deltaTime);
+
+  private:
+    Random rng;
+    float timer;
+    float target; // Where the paddle's center should go
+};
+
+// Top of the ball when it reaches x = targetX, reflecting off the walls at
+// minY and maxY. Each bounce mirrors the line, so the straight line result is
+// folded back into [minY, maxY] with a single modulo.
+float PredictInterceptY(glm::vec2 position, glm::vec2 velocity, float targetX, float minY, float maxY);
+
+// Simple bot for both paddles: each one chases the ball once it crossed into
+// its half. Cheap and good enough to produce real rallies in batch runs.
+unsigned int TrackBall(const Simulation &match);
+
+#endif
\ No newline at end of file
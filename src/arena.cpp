@@ -0,0 +1,197 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ball_kernel.hpp"
+
+Arena::Arena(unsigned int width, unsigned int height, unsigned int seed)
+    : Paddle1Score(0), Paddle2Score(0), Width(width), Height(height),
+      random(seed), maxRadius(0.0f), cellSize(1.0f), gridWidth(1), gridHeight(1)
+{
+}
+
+void Arena::AddBall(float x, float y, float vx, float vy, float radius)
+{
+    this->PositionX.push_back(x);
+    this->PositionY.push_back(y);
+    this->VelocityX.push_back(vx);
+    this->VelocityY.push_back(vy);
+    this->Radius.push_back(radius);
+    if (radius > this->maxRadius)
+    {
+        // Cells as big as the largest ball: every possible contact is found in the 3x3 neighbourhood
+        this->maxRadius = radius;
+        this->cellSize = 2.0f * radius;
+        this->gridWidth = static_cast<unsigned int>(std::ceil(this->Width / this->cellSize));
+        this->gridHeight = static_cast<unsigned int>(std::ceil(this->Height / this->cellSize));
+    }
+}
+
+void Arena::Spawn(unsigned int count, float radius)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        this->AddBall(0.0f, 0.0f, 0.0f, 0.0f, radius);
+        this->serve(this->Count() - 1);
+    }
+}
+
+unsigned int Arena::Update(float deltaTime, const GameObject &paddle1, const GameObject &paddle2)
+{
+    unsigned int events = EVENT_NONE;
+    this->integrate(deltaTime);
+    this->buildGrid();
+    this->collideBalls();
+    events |= this->collidePaddle(paddle1);
+    events |= this->collidePaddle(paddle2);
+    events |= this->scoreBalls();
+    return events;
+}
+
+void Arena::integrate(float deltaTime)
+{
+    IntegrateBalls(this->PositionX.data(), this->PositionY.data(), this->VelocityX.data(), this->VelocityY.data(),
+                   this->Radius.data(), this->Count(), deltaTime, static_cast<float>(this->Height));
+}
+
+unsigned int Arena::cellOf(float x, float y) const
+{
+    int cx = static_cast<int>(x / this->cellSize);
+    int cy = static_cast<int>(y / this->cellSize);
+    cx = std::min(std::max(cx, 0), static_cast<int>(this->gridWidth) - 1);
+    cy = std::min(std::max(cy, 0), static_cast<int>(this->gridHeight) - 1);
+    return cy * this->gridWidth + cx;
+}
+
+void Arena::buildGrid()
+{
+    unsigned int count = this->Count();
+    unsigned int cells = this->gridWidth * this->gridHeight;
+    // Counting sort of the balls by cell: count, prefix sum, scatter
+    this->cellStart.assign(cells + 1, 0);
+    this->ballCell.resize(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int cell = this->cellOf(this->PositionX[i], this->PositionY[i]);
+        this->ballCell[i] = cell;
+        this->cellStart[cell + 1]++;
+    }
+    for (unsigned int c = 0; c < cells; ++c)
+        this->cellStart[c + 1] += this->cellStart[c];
+    this->cellBalls.resize(count);
+    this->cellCursor.resize(cells);
+    std::copy(this->cellStart.begin(), this->cellStart.end() - 1, this->cellCursor.begin());
+    for (unsigned int i = 0; i < count; ++i)
+        this->cellBalls[this->cellCursor[this->ballCell[i]]++] = i;
+}
+
+void Arena::collideBalls()
+{
+    unsigned int count = this->Count();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        int cx = this->ballCell[i] % this->gridWidth;
+        int cy = this->ballCell[i] / this->gridWidth;
+        for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, static_cast<int>(this->gridHeight) - 1); ++y)
+        {
+            for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, static_cast<int>(this->gridWidth) - 1); ++x)
+            {
+                unsigned int cell = y * this->gridWidth + x;
+                for (unsigned int k = this->cellStart[cell]; k < this->cellStart[cell + 1]; ++k)
+                {
+                    unsigned int j = this->cellBalls[k];
+                    if (j <= i) // Every pair only once
+                        continue;
+                    float dx = this->PositionX[j] - this->PositionX[i];
+                    float dy = this->PositionY[j] - this->PositionY[i];
+                    float minDistance = this->Radius[i] + this->Radius[j];
+                    float distanceSquared = dx * dx + dy * dy;
+                    if (distanceSquared >= minDistance * minDistance || distanceSquared == 0.0f)
+                        continue;
+                    float distance = std::sqrt(distanceSquared);
+                    float nx = dx / distance;
+                    float ny = dy / distance;
+                    // Push both balls apart, weighted by mass (proportional to the area)
+                    float massI = this->Radius[i] * this->Radius[i];
+                    float massJ = this->Radius[j] * this->Radius[j];
+                    float overlap = minDistance - distance;
+                    float shareI = massJ / (massI + massJ);
+                    float shareJ = massI / (massI + massJ);
+                    this->PositionX[i] -= nx * overlap * shareI;
+                    this->PositionY[i] -= ny * overlap * shareI;
+                    this->PositionX[j] += nx * overlap * shareJ;
+                    this->PositionY[j] += ny * overlap * shareJ;
+                    // Elastic collision along the normal, only if approaching
+                    float approach = (this->VelocityX[i] - this->VelocityX[j]) * nx + (this->VelocityY[i] - this->VelocityY[j]) * ny;
+                    if (approach <= 0.0f)
+                        continue;
+                    float impulse = 2.0f * approach / (massI + massJ);
+                    this->VelocityX[i] -= impulse * massJ * nx;
+                    this->VelocityY[i] -= impulse * massJ * ny;
+                    this->VelocityX[j] += impulse * massI * nx;
+                    this->VelocityY[j] += impulse * massI * ny;
+                }
+            }
+        }
+    }
+}
+
+unsigned int Arena::collidePaddle(const GameObject &paddle)
+{
+    unsigned int events = EVENT_NONE;
+    glm::vec2 position = ToGlm(paddle.Position), size = ToGlm(paddle.Size);
+    // Balls only bounce off the side facing the court
+    bool leftPaddle = position.x + size.x / 2 < this->Width / 2.0f;
+    for (unsigned int i = 0; i < this->Count(); ++i)
+    {
+        if (leftPaddle ? this->VelocityX[i] >= 0.0f : this->VelocityX[i] <= 0.0f)
+            continue;
+        // Circle - AABB: closest point of the paddle to the ball's center
+        float closestX = std::min(std::max(this->PositionX[i], position.x), position.x + size.x);
+        float closestY = std::min(std::max(this->PositionY[i], position.y), position.y + size.y);
+        float dx = this->PositionX[i] - closestX;
+        float dy = this->PositionY[i] - closestY;
+        if (dx * dx + dy * dy > this->Radius[i] * this->Radius[i])
+            continue;
+        events |= EVENT_PADDLE_HIT;
+        this->VelocityX[i] = -this->VelocityX[i];
+        if (leftPaddle)
+            this->PositionX[i] = position.x + size.x + this->Radius[i];
+        else
+            this->PositionX[i] = position.x - this->Radius[i];
+    }
+    return events;
+}
+
+unsigned int Arena::scoreBalls()
+{
+    unsigned int events = EVENT_NONE;
+    for (unsigned int i = 0; i < this->Count(); ++i)
+    {
+        if (this->PositionX[i] + this->Radius[i] <= 0.0f)
+        {
+            this->Paddle2Score++;
+            events |= EVENT_PLAYER2_SCORED;
+            this->serve(i);
+        }
+        else if (this->PositionX[i] - this->Radius[i] >= this->Width)
+        {
+            this->Paddle1Score++;
+            events |= EVENT_PLAYER1_SCORED;
+            this->serve(i);
+        }
+    }
+    return events;
+}
+
+void Arena::serve(unsigned int index)
+{
+    // Somewhere around the center line, flying in a random direction that isn't too steep
+    float angle = this->random.Range(-0.8f, 0.8f);
+    float direction = (this->random.Next() & 1) ? 1.0f : -1.0f;
+    this->PositionX[index] = this->Width / 2.0f + this->random.Range(-50.0f, 50.0f);
+    this->PositionY[index] = this->random.Range(this->Radius[index], this->Height - this->Radius[index]);
+    this->VelocityX[index] = direction * ARENA_BALL_SPEED * std::cos(angle);
+    this->VelocityY[index] = ARENA_BALL_SPEED * std::sin(angle);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+
+#include "game_object.hpp"
+#include "random.hpp"
+#include "simulation.hpp"
+
+const unsigned int ARENA_BALL_COUNT = 2000;
+const float ARENA_BALL_RADIUS = 4.0f;
+const float ARENA_BALL_SPEED = 300.0f;
+// Points either side needs to win an arena match. Every ball that gets past a
+// paddle scores, so with ARENA_BALL_COUNT balls this is about half a minute.
+const int ARENA_MAX_SCORE = 10000;
+
+// Multi-ball stress mode. Balls are stored as structure of arrays (centers,
+// velocities, radii) and ball-ball collisions go through a uniform grid, so
+// the cost grows linearly with the number of balls.
+class Arena
+{
+  public:
+    std::vector<float> PositionX, PositionY;
+    std::vector<float> VelocityX, VelocityY;
+    std::vector<float> Radius;
+    int Paddle1Score, Paddle2Score;
+    unsigned int Width, Height;
+
+    Arena(unsigned int width, unsigned int height, unsigned int seed = 1);
+
+    void AddBall(float x, float y, float vx, float vy, float radius);
+    void Spawn(unsigned int count, float radius = ARENA_BALL_RADIUS);
+    unsigned int Update(float deltaTime, const GameObject &paddle1, const GameObject &paddle2);
+    unsigned int Count() const { return static_cast<unsigned int>(this->PositionX.size()); }
+
+  private:
+    Random random;
+    float maxRadius;
+    // Uniform grid, rebuilt every step with a counting sort
+    float cellSize;
+    unsigned int gridWidth, gridHeight;
+    std::vector<unsigned int> cellStart; // First entry of every cell in cellBalls
+    std::vector<unsigned int> cellBalls; // Ball indices ordered by cell
+    std::vector<unsigned int> ballCell;
+    std::vector<unsigned int> cellCursor; // Next free entry of every cell while scattering
+
+    void integrate(float deltaTime);
+    void buildGrid();
+    void collideBalls();
+    unsigned int collidePaddle(const GameObject &paddle);
+    unsigned int scoreBalls();
+    void serve(unsigned int index);
+    unsigned int cellOf(float x, float y) const;
+};
+
+#endif
\ No newline at end of file
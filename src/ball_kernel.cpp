@@ -0,0 +1,191 @@
+#include "ball_kernel.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "random.hpp"
+
+#ifdef BALL_KERNEL_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+void IntegrateBallsScalar(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                          const float *radius, unsigned int count, float deltaTime, float height)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        positionX[i] += velocityX[i] * deltaTime;
+        positionY[i] += velocityY[i] * deltaTime;
+        if (positionY[i] - radius[i] <= 0.0f)
+        {
+            velocityY[i] = -velocityY[i];
+            positionY[i] = radius[i];
+        }
+        else if (positionY[i] + radius[i] >= height)
+        {
+            velocityY[i] = -velocityY[i];
+            positionY[i] = height - radius[i];
+        }
+    }
+}
+
+#ifdef BALL_KERNEL_X86
+void IntegrateBallsSSE2(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                        const float *radius, unsigned int count, float deltaTime, float height)
+{
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 h = _mm_set1_ps(height);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 vy = _mm_loadu_ps(velocityY + i);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(_mm_loadu_ps(velocityX + i), dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(vy, dt));
+        // Same tests as the scalar path, as lane masks
+        __m128 top = _mm_cmple_ps(_mm_sub_ps(y, r), zero);
+        __m128 bottom = _mm_andnot_ps(top, _mm_cmpge_ps(_mm_add_ps(y, r), h));
+        __m128 hit = _mm_or_ps(top, bottom);
+        // Negation by flipping the sign bit is exactly what -v does
+        vy = _mm_xor_ps(vy, _mm_and_ps(hit, sign));
+        y = _mm_or_ps(_mm_andnot_ps(hit, y),
+                      _mm_or_ps(_mm_and_ps(top, r), _mm_and_ps(bottom, _mm_sub_ps(h, r))));
+        _mm_storeu_ps(positionX + i, x);
+        _mm_storeu_ps(positionY + i, y);
+        _mm_storeu_ps(velocityY + i, vy);
+    }
+    IntegrateBallsScalar(positionX + i, positionY + i, velocityX + i, velocityY + i, radius + i, count - i, deltaTime, height);
+}
+
+TARGET_AVX2 void IntegrateBallsAVX2(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                                    const float *radius, unsigned int count, float deltaTime, float height)
+{
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 h = _mm256_set1_ps(height);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 vy = _mm256_loadu_ps(velocityY + i);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(positionX + i), _mm256_mul_ps(_mm256_loadu_ps(velocityX + i), dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(positionY + i), _mm256_mul_ps(vy, dt));
+        __m256 top = _mm256_cmp_ps(_mm256_sub_ps(y, r), zero, _CMP_LE_OQ);
+        __m256 bottom = _mm256_andnot_ps(top, _mm256_cmp_ps(_mm256_add_ps(y, r), h, _CMP_GE_OQ));
+        __m256 hit = _mm256_or_ps(top, bottom);
+        vy = _mm256_xor_ps(vy, _mm256_and_ps(hit, sign));
+        y = _mm256_blendv_ps(y, r, top);
+        y = _mm256_blendv_ps(y, _mm256_sub_ps(h, r), bottom);
+        _mm256_storeu_ps(positionX + i, x);
+        _mm256_storeu_ps(positionY + i, y);
+        _mm256_storeu_ps(velocityY + i, vy);
+    }
+    IntegrateBallsSSE2(positionX + i, positionY + i, velocityX + i, velocityY + i, radius + i, count - i, deltaTime, height);
+}
+
+static bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    // The OS has to save the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+    if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+BallKernel SelectBallKernel()
+{
+#ifdef BALL_KERNEL_X86
+    if (cpuSupportsAVX2())
+        return IntegrateBallsAVX2;
+    return IntegrateBallsSSE2;
+#else
+    return IntegrateBallsScalar;
+#endif
+}
+
+const char *BallKernelName(BallKernel kernel)
+{
+#ifdef BALL_KERNEL_X86
+    if (kernel == IntegrateBallsAVX2)
+        return "avx2";
+    if (kernel == IntegrateBallsSSE2)
+        return "sse2";
+#endif
+    if (kernel == IntegrateBallsScalar)
+        return "scalar";
+    return "unknown";
+}
+
+void IntegrateBalls(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                    const float *radius, unsigned int count, float deltaTime, float height)
+{
+    static const BallKernel kernel = SelectBallKernel();
+    kernel(positionX, positionY, velocityX, velocityY, radius, count, deltaTime, height);
+}
+
+bool VerifyBallKernels(unsigned int count, unsigned int seed)
+{
+    const float height = 600.0f;
+    const float deltaTime = 1.0f / 60.0f;
+    Random random(seed);
+    std::vector<float> positionX(count), positionY(count), velocityX(count), velocityY(count), radius(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // Spread balls past both walls too so every branch gets exercised
+        radius[i] = random.Range(1.0f, 12.0f);
+        positionX[i] = random.Range(0.0f, 800.0f);
+        positionY[i] = random.Range(-20.0f, height + 20.0f);
+        velocityX[i] = random.Range(-900.0f, 900.0f);
+        velocityY[i] = random.Range(-900.0f, 900.0f);
+    }
+
+    std::vector<BallKernel> kernels;
+#ifdef BALL_KERNEL_X86
+    kernels.push_back(IntegrateBallsSSE2);
+    if (cpuSupportsAVX2())
+        kernels.push_back(IntegrateBallsAVX2);
+#endif
+    bool success = true;
+    for (size_t k = 0; k < kernels.size(); ++k)
+    {
+        std::vector<float> expectedX(positionX), expectedY(positionY), expectedVY(velocityY);
+        std::vector<float> actualX(positionX), actualY(positionY), actualVY(velocityY);
+        // A few steps so reflected state is fed back in
+        for (int step = 0; step < 8; ++step)
+        {
+            IntegrateBallsScalar(expectedX.data(), expectedY.data(), velocityX.data(), expectedVY.data(), radius.data(), count, deltaTime, height);
+            kernels[k](actualX.data(), actualY.data(), velocityX.data(), actualVY.data(), radius.data(), count, deltaTime, height);
+        }
+        size_t bytes = count * sizeof(float);
+        if (std::memcmp(expectedX.data(), actualX.data(), bytes) != 0 ||
+            std::memcmp(expectedY.data(), actualY.data(), bytes) != 0 ||
+            std::memcmp(expectedVY.data(), actualVY.data(), bytes) != 0)
+        {
+            std::cout << "ERROR::BALL_KERNEL: " << BallKernelName(kernels[k]) << " differs from the scalar reference" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef BALL_KERNEL_H
+#define BALL_KERNEL_H
+
+// Batch integration of ball centers over structure-of-arrays buffers: moves
+// every ball by its velocity and reflects it off the top and bottom walls.
+// All implementations produce bit-identical results to the scalar reference.
+typedef void (*BallKernel)(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                           const float *radius, unsigned int count, float deltaTime, float height);
+
+void IntegrateBallsScalar(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                          const float *radius, unsigned int count, float deltaTime, float height);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BALL_KERNEL_X86
+void IntegrateBallsSSE2(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                        const float *radius, unsigned int count, float deltaTime, float height);
+void IntegrateBallsAVX2(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                        const float *radius, unsigned int count, float deltaTime, float height);
+#endif
+
+// Best kernel for the running CPU (AVX2 > SSE2 > scalar), chosen once
+BallKernel SelectBallKernel();
+const char *BallKernelName(BallKernel kernel);
+void IntegrateBalls(float *positionX, float *positionY, const float *velocityX, float *velocityY,
+                    const float *radius, unsigned int count, float deltaTime, float height);
+
+// Runs every kernel available on this CPU over the same random input and
+// compares the results bit by bit against the scalar reference
+bool VerifyBallKernels(unsigned int count, unsigned int seed);
+
+#endif
\ No newline at end of file
@@ -3,27 +3,10 @@
 BallObject::BallObject()
     : GameObject(), Radius(10.0f) {}
 
-BallObject::BallObject(glm::vec2 pos, GLfloat radius, glm::vec2 velocity)
-    : GameObject(pos, glm::vec2(radius * 2, radius * 2), glm::vec3(1.0f), velocity), Radius(radius) {}
+BallObject::BallObject(Vec2 pos, Real radius, Vec2 velocity)
+    : GameObject(pos, Vec2(radius * 2, radius * 2), glm::vec3(1.0f), velocity), Radius(radius) {}
 
-glm::vec2 BallObject::Move(GLfloat deltaTime, GLuint windowHeight)
-{
-    this->Position += this->Velocity * deltaTime;
-    if (this->Position.y <= 0.0f)
-    {
-        this->Velocity.y = -this->Velocity.y;
-        this->Position.y = 0.0f;
-    }
-    else if (this->Position.y + this->Size.y >= windowHeight)
-    {
-        this->Velocity.y = -this->Velocity.y;
-        this->Position.y = windowHeight - this->Size.x;
-    }
-
-    return this->Position;
-}
-
-void BallObject::Reset(glm::vec2 position, glm::vec2 velocity)
+void BallObject::Reset(Vec2 position, Vec2 velocity)
 {
     this->Position = position;
     this->Velocity = velocity;
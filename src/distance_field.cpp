@@ -0,0 +1,100 @@
+#include "distance_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const float DISTANCE_INFINITY = 1e20f;
+
+// Squared distance transform of one row or column (Felzenszwalb and
+// Huttenlocher): the lower envelope of the parabolas rooted at every sample
+static void transform(float *values, int count, float *distances, int *roots, float *bounds)
+{
+    int k = 0;
+    roots[0] = 0;
+    bounds[0] = -DISTANCE_INFINITY;
+    bounds[1] = DISTANCE_INFINITY;
+    for (int q = 1; q < count; ++q)
+    {
+        // Where the parabola of q overtakes the lowest one so far (bounds[0]
+        // is minus infinity, so k never drops below 0)
+        float s = ((values[q] + q * q) - (values[roots[k]] + roots[k] * roots[k])) / (2.0f * (q - roots[k]));
+        while (s <= bounds[k])
+        {
+            --k;
+            s = ((values[q] + q * q) - (values[roots[k]] + roots[k] * roots[k])) / (2.0f * (q - roots[k]));
+        }
+        ++k;
+        roots[k] = q;
+        bounds[k] = s;
+        bounds[k + 1] = DISTANCE_INFINITY;
+    }
+    k = 0;
+    for (int q = 0; q < count; ++q)
+    {
+        while (bounds[k + 1] < q)
+            ++k;
+        int r = roots[k];
+        distances[q] = (q - r) * (q - r) + values[r];
+    }
+    std::copy(distances, distances + count, values);
+}
+
+// Squared distance of every pixel to the nearest pixel that is set
+static void transform2D(std::vector<float> &grid, int width, int height)
+{
+    int size = std::max(width, height);
+    std::vector<float> line(size), distances(size), bounds(size + 1);
+    std::vector<int> roots(size);
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+            line[y] = grid[y * width + x];
+        transform(line.data(), height, distances.data(), roots.data(), bounds.data());
+        for (int y = 0; y < height; ++y)
+            grid[y * width + x] = line[y];
+    }
+    for (int y = 0; y < height; ++y)
+        transform(&grid[y * width], width, distances.data(), roots.data(), bounds.data());
+}
+
+void DistanceField(const unsigned char *bitmap, int width, int height, int pitch, int downscale, int spread,
+                   std::vector<unsigned char> &field, int &fieldWidth, int &fieldHeight)
+{
+    // Pad, and round up to whole output pixels
+    int padding = spread * downscale;
+    fieldWidth = (width + 2 * padding + downscale - 1) / downscale;
+    fieldHeight = (height + 2 * padding + downscale - 1) / downscale;
+    int gridWidth = fieldWidth * downscale, gridHeight = fieldHeight * downscale;
+    std::vector<float> outside(gridWidth * gridHeight, DISTANCE_INFINITY);
+    std::vector<float> inside(gridWidth * gridHeight, 0.0f);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            if (bitmap[y * pitch + x] >= 128)
+            {
+                int cell = (y + padding) * gridWidth + x + padding;
+                outside[cell] = 0.0f;
+                inside[cell] = DISTANCE_INFINITY;
+            }
+    transform2D(outside, gridWidth, gridHeight); // Outside pixels: distance to the shape
+    transform2D(inside, gridWidth, gridHeight);  // Inside pixels: distance to the background
+
+    field.assign(fieldWidth * fieldHeight, 0);
+    for (int fy = 0; fy < fieldHeight; ++fy)
+        for (int fx = 0; fx < fieldWidth; ++fx)
+        {
+            float sum = 0.0f;
+            for (int y = fy * downscale; y < (fy + 1) * downscale; ++y)
+                for (int x = fx * downscale; x < (fx + 1) * downscale; ++x)
+                {
+                    int cell = y * gridWidth + x;
+                    // Pixel centers are half a pixel away from the outline
+                    if (outside[cell] > 0.0f)
+                        sum += std::sqrt(outside[cell]) - 0.5f;
+                    else
+                        sum -= std::sqrt(inside[cell]) - 0.5f;
+                }
+            float distance = sum / (downscale * downscale) / downscale; // In output pixels, positive outside
+            float value = 128.0f - distance / spread * 128.0f;
+            field[fy * fieldWidth + fx] = static_cast<unsigned char>(std::min(std::max(value, 0.0f), 255.0f));
+        }
+}
@@ -0,0 +1,15 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <vector>
+
+// Signed distance field of a coverage bitmap (0-255, 128 and up is inside).
+// Distances are measured on the bitmap, then averaged over downscale x
+// downscale blocks, so rendering the bitmap large gives a smooth, sharp
+// field at the output size. The output is padded by spread pixels on each
+// side; a value of 128 is the outline, 255 and 0 are spread output pixels or
+// more inside and outside of it.
+void DistanceField(const unsigned char *bitmap, int width, int height, int pitch, int downscale, int spread,
+                   std::vector<unsigned char> &field, int &fieldWidth, int &fieldHeight);
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <cmath>
+#include <cstdint>
+
+// Signed Q16.16 number. Every operation is plain integer math, so results are
+// bit identical whatever the compiler, optimization flags or CPU. Products and
+// quotients go through 64 bits; the range is about +-32767 with a resolution
+// of 1/65536, plenty for a court of a few hundred pixels.
+class Fixed
+{
+  public:
+    static const int FRACTION_BITS = 16;
+    static const int32_t ONE = 1 << FRACTION_BITS;
+
+    int32_t Raw;
+
+    Fixed() : Raw(0) {}
+    Fixed(int value) : Raw(value * ONE) {}
+    Fixed(unsigned int value) : Raw(static_cast<int32_t>(value) * ONE) {}
+    // Conversions from floating point only happen for constants and inputs
+    // (tick length), rounding to nearest so both sides agree on the result
+    Fixed(double value) : Raw(static_cast<int32_t>(std::floor(value * ONE + 0.5))) {}
+    Fixed(float value) : Fixed(static_cast<double>(value)) {}
+
+    static Fixed FromRaw(int32_t raw)
+    {
+        Fixed value;
+        value.Raw = raw;
+        return value;
+    }
+
+    float ToFloat() const { return static_cast<float>(this->Raw) / ONE; }
+
+    Fixed operator-() const { return FromRaw(-this->Raw); }
+    Fixed &operator+=(Fixed other) { this->Raw += other.Raw; return *this; }
+    Fixed &operator-=(Fixed other) { this->Raw -= other.Raw; return *this; }
+    Fixed &operator*=(Fixed other)
+    {
+        this->Raw = static_cast<int32_t>((static_cast<int64_t>(this->Raw) * other.Raw) >> FRACTION_BITS);
+        return *this;
+    }
+    Fixed &operator/=(Fixed other)
+    {
+        this->Raw = static_cast<int32_t>(static_cast<int64_t>(this->Raw) * ONE / other.Raw);
+        return *this;
+    }
+};
+
+inline Fixed operator+(Fixed a, Fixed b) { return a += b; }
+inline Fixed operator-(Fixed a, Fixed b) { return a -= b; }
+inline Fixed operator*(Fixed a, Fixed b) { return a *= b; }
+inline Fixed operator/(Fixed a, Fixed b) { return a /= b; }
+inline bool operator==(Fixed a, Fixed b) { return a.Raw == b.Raw; }
+inline bool operator!=(Fixed a, Fixed b) { return a.Raw != b.Raw; }
+inline bool operator<(Fixed a, Fixed b) { return a.Raw < b.Raw; }
+inline bool operator>(Fixed a, Fixed b) { return a.Raw > b.Raw; }
+inline bool operator<=(Fixed a, Fixed b) { return a.Raw <= b.Raw; }
+inline bool operator>=(Fixed a, Fixed b) { return a.Raw >= b.Raw; }
+
+// Integer square root (floor), one result bit per iteration
+inline uint64_t SquareRoot(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > value)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+            result >>= 1;
+        bit >>= 2;
+    }
+    return result;
+}
+
+// Two component vector with the handful of operations the rules need
+struct FixedVec2
+{
+    Fixed x, y;
+
+    FixedVec2() {}
+    explicit FixedVec2(Fixed scalar) : x(scalar), y(scalar) {}
+    FixedVec2(Fixed x, Fixed y) : x(x), y(y) {}
+
+    FixedVec2 operator-() const { return FixedVec2(-this->x, -this->y); }
+    FixedVec2 &operator+=(const FixedVec2 &other) { this->x += other.x; this->y += other.y; return *this; }
+    FixedVec2 &operator-=(const FixedVec2 &other) { this->x -= other.x; this->y -= other.y; return *this; }
+    FixedVec2 &operator*=(Fixed scalar) { this->x *= scalar; this->y *= scalar; return *this; }
+    FixedVec2 &operator/=(Fixed scalar) { this->x /= scalar; this->y /= scalar; return *this; }
+};
+
+inline FixedVec2 operator+(FixedVec2 a, const FixedVec2 &b) { return a += b; }
+inline FixedVec2 operator-(FixedVec2 a, const FixedVec2 &b) { return a -= b; }
+inline FixedVec2 operator*(FixedVec2 a, Fixed scalar) { return a *= scalar; }
+inline FixedVec2 operator/(FixedVec2 a, Fixed scalar) { return a /= scalar; }
+inline bool operator==(const FixedVec2 &a, const FixedVec2 &b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const FixedVec2 &a, const FixedVec2 &b) { return !(a == b); }
+
+inline Fixed Length(const FixedVec2 &vector)
+{
+    // sqrt((x * 2^16)^2 + (y * 2^16)^2) is the length already scaled by 2^16
+    int64_t x = vector.x.Raw, y = vector.y.Raw;
+    return Fixed::FromRaw(static_cast<int32_t>(SquareRoot(static_cast<uint64_t>(x * x + y * y))));
+}
+
+inline FixedVec2 Normalize(const FixedVec2 &vector)
+{
+    Fixed length = Length(vector);
+    if (length.Raw == 0)
+        return vector;
+    return vector / length;
+}
+
+#endif
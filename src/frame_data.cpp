@@ -0,0 +1,33 @@
+#include "frame_data.hpp"
+
+#include <cstring>
+
+#include "shader.hpp"
+
+static_assert(sizeof(FrameData) == 96, "FrameData must match the std140 layout of the shader block");
+
+FrameDataBuffer::FrameDataBuffer()
+    : Data(), uploaded(), valid(false)
+{
+    glGenBuffers(1, &this->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, this->UBO);
+}
+
+FrameDataBuffer::~FrameDataBuffer()
+{
+    glDeleteBuffers(1, &this->UBO);
+}
+
+void FrameDataBuffer::Upload()
+{
+    if (this->valid && std::memcmp(&this->Data, &this->uploaded, sizeof(FrameData)) == 0)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &this->Data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    this->uploaded = this->Data;
+    this->valid = true;
+}
@@ -0,0 +1,36 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Per frame constants, laid out as the std140 FrameData block the shaders
+// declare (see FRAME_DATA_BINDING in shader.hpp)
+struct FrameData
+{
+    glm::mat4 Projection;
+    glm::vec2 Viewport; // Framebuffer size in pixels
+    GLfloat Time;
+    GLint Chaos, Confuse, Shake; // Post processing effects (std140 bools)
+    GLint Padding[2];            // The block size is a multiple of 16 bytes
+};
+
+// Uniform buffer holding the FrameData every program reads. Fill Data, then
+// Upload once per frame: the buffer is only written when something changed.
+class FrameDataBuffer
+{
+  public:
+    FrameData Data;
+
+    FrameDataBuffer();
+    ~FrameDataBuffer();
+
+    void Upload();
+
+  private:
+    GLuint UBO;
+    FrameData uploaded;
+    bool valid; // uploaded matches the buffer contents
+};
+
+#endif
@@ -1,4 +1,5 @@
-#include <sstream>
+#include <cmath>
+#include <cstdio>
 
 #include <irrKlang.h>
 using namespace irrklang;
@@ -6,27 +7,30 @@ using namespace irrklang;
 #include "game.hpp"
 #include "resource_manager.hpp"
 #include "sprite_renderer.hpp"
-#include "game_object.hpp"
-#include "ball_object.hpp"
 #include "particle_generator.hpp"
 #include "post_processor.hpp"
 #include "text_renderer.hpp"
+#include "render_queue.hpp"
+#include "frame_data.hpp"
 
 SpriteRenderer    *Renderer;
 ParticleGenerator *Particles;
 PostProcessor     *Effects;
-GameObject        *Paddle1, *Paddle2;
-BallObject        *Ball;
 ISoundEngine      *SoundEngine = createIrrKlangDevice();
 TextRenderer      *Text;
+RenderQueue       *Frame;
+FrameDataBuffer   *FrameConstants;
+
+// Retained HUD text
+TextHandle ScoreText, StartText, ComputerText, WinText;
 
 GLfloat ShakeTime = 0.0f;
-int MaxScore = 10;
-int Paddle1Score = 0;
-int Paddle2Score = 0;
+const double EFFECTS_TIME_PERIOD = 6.28318530717958647692;
 
 Game::Game(GLuint windowWidth, GLuint windowHeight, GLuint framebufferWidth, GLuint framebufferHeight)
-    : State(GAME_MENU), Keys(),
+    : Match(windowWidth, windowHeight), PreviousMatch(windowWidth, windowHeight), MultiBall(nullptr),
+      Bot(nullptr), Recorder(nullptr), Playback(nullptr), PlaybackTick(0),
+      Connection(nullptr), Netplay(nullptr), Keys(),
       WindowWidth(windowWidth), WindowHeight(windowHeight),
       FramebufferWidth(framebufferWidth), FramebufferHeight(framebufferHeight)
 {
@@ -38,201 +42,293 @@ Game::~Game()
     delete Particles;
     delete Effects;
     delete Text;
+    delete Frame;
+    delete FrameConstants;
+    delete this->MultiBall;
+    delete this->Bot;
+    delete this->Recorder;
+    delete this->Playback;
+    delete this->Netplay;
+    delete this->Connection;
     SoundEngine->drop();
 }
 
-void Game::Init()
+void Game::Init(bool gpuParticles)
 {
     // Load shaders
     ResourceManager::LoadShader("../src/shaders/sprite.vs", "../src/shaders/sprite.fs", nullptr, "sprite");
     ResourceManager::LoadShader("../src/shaders/particle.vs", "../src/shaders/particle.fs", nullptr, "particle");
-    ResourceManager::LoadShader("../src/shaders/post_processing.vs", "../src/shaders/post_processing.fs", nullptr, "postprocessing");
-    // Configure shaders
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(this->WindowWidth), static_cast<GLfloat>(this->WindowHeight), 0.0f, -1.0f, 1.0f);
-    ResourceManager::GetShader("sprite").Use().SetMatrix4("projection", projection);
-    ResourceManager::GetShader("particle").Use().SetMatrix4("projection", projection);
+    ResourceManager::LoadFeedbackShader("../src/shaders/particle_update.vs", PARTICLE_FEEDBACK_VARYINGS, PARTICLE_FEEDBACK_VARYING_COUNT, "particle_update");
+    // Configure shaders: the projection is shared by all of them through the FrameData block
+    FrameConstants = new FrameDataBuffer();
+    FrameConstants->Data.Projection = glm::ortho(0.0f, static_cast<GLfloat>(this->WindowWidth), static_cast<GLfloat>(this->WindowHeight), 0.0f, -1.0f, 1.0f);
     // Set render-specific controls
     Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
-    Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), 500);
-    Effects = new PostProcessor(ResourceManager::GetShader("postprocessing"), this->FramebufferWidth, this->FramebufferHeight);
-    Text = new TextRenderer(this->WindowWidth, this->WindowHeight);
+    if (gpuParticles)
+        Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), ResourceManager::GetShader("particle_update"), 500);
+    else
+        Particles = new ParticleGenerator(ResourceManager::GetShader("particle"), 500);
+    Effects = new PostProcessor(this->FramebufferWidth, this->FramebufferHeight);
+    Text = new TextRenderer();
     Text->Load("../assets/PressStart2P-Regular.ttf", 32);
+    ScoreText = Text->CreateText();
+    StartText = Text->CreateText();
+    ComputerText = Text->CreateText();
+    WinText = Text->CreateText();
+    Text->SetText(StartText, "Press ENTER to start", 260.0f, this->WindowHeight / 2 - 25.0f, 0.5f);
+    Text->SetText(ComputerText, "Press 1 to play the computer", 176.0f, this->WindowHeight / 2 + 70.0f, 0.5f);
+    Frame = new RenderQueue();
+}
 
-    // Configure game objects
-    glm::vec2 paddle1Position = glm::vec2(
-        10.0f,
-        this->WindowHeight / 2 - PADDLE_SIZE.y / 2);
-    Paddle1 = new GameObject(paddle1Position, PADDLE_SIZE);
+bool Game::StartRecording(const std::string &file, GLfloat tickLength)
+{
+    delete this->Recorder;
+    this->Recorder = new ReplayWriter();
+    if (this->Recorder->Open(file, this->WindowWidth, this->WindowHeight, tickLength))
+        return true;
+    delete this->Recorder;
+    this->Recorder = nullptr;
+    return false;
+}
 
-    glm::vec2 paddle2Position = glm::vec2(
-        this->WindowWidth - PADDLE_SIZE.x - 10.0f,
-        this->WindowHeight / 2 - PADDLE_SIZE.y / 2);
-    Paddle2 = new GameObject(paddle2Position, PADDLE_SIZE);
+bool Game::StartPlayback(const std::string &file)
+{
+    delete this->Playback;
+    this->Playback = new ReplayReader();
+    if (!this->Playback->Open(file))
+    {
+        delete this->Playback;
+        this->Playback = nullptr;
+        return false;
+    }
+    this->PlaybackTick = 0;
+    Particles->Pool.Clear();
+    this->Playback->Seek(0, this->Match, Particles->Pool.Rng.State);
+    this->PreviousMatch = this->Match;
+    return true;
+}
 
-    glm::vec2 ballPosition = glm::vec2(this->WindowWidth / 2, this->WindowHeight / 2);
-    Ball = new BallObject(ballPosition, BALL_RADIUS, INITIAL_BALL_VELOCITY);
+bool Game::StartNetplay(const std::string &host, unsigned short port, GLfloat tickLength)
+{
+    delete this->Netplay;
+    this->Netplay = nullptr;
+    delete this->Connection;
+    this->Connection = new UdpTransport();
+    bool connected = host.empty() ? this->Connection->Host(port) : this->Connection->Join(host, port);
+    if (!connected)
+    {
+        delete this->Connection;
+        this->Connection = nullptr;
+        return false;
+    }
+    // Both peers start from the same state and only exchange inputs
+    this->Match = Simulation(this->WindowWidth, this->WindowHeight);
+    this->PreviousMatch = this->Match;
+    this->Netplay = new RollbackSession(this->Match, host.empty() ? PADDLE_LEFT : PADDLE_RIGHT, *this->Connection, tickLength);
+    return true;
 }
 
-void Game::ProcessInput(GLfloat deltaTime)
+void Game::Step(GLfloat deltaTime)
 {
-    if (this->State == GAME_ACTIVE)
+    this->PreviousMatch = this->Match;
+    unsigned int buttons = this->ProcessInput();
+    if (this->Playback != nullptr)
     {
-        GLfloat deltaSpace = PADDLE_VELOCITY * deltaTime;
-        // Move paddle one
-        if (this->Keys[GLFW_KEY_W])
-        {
-            if (Paddle1->Position.y >= 0)
-                Paddle1->Position.y -= deltaSpace;
-        }
-        if (this->Keys[GLFW_KEY_S])
-        {
-            if (Paddle1->Position.y <= this->WindowHeight - Paddle1->Size.y)
-                Paddle1->Position.y += deltaSpace;
-        }
-        // Move paddle two
-        if (this->Keys[GLFW_KEY_UP])
-        {
-            if (Paddle2->Position.y >= 0)
-                Paddle2->Position.y -= deltaSpace;
-        }
-        if (this->Keys[GLFW_KEY_DOWN])
+        if (this->PlaybackTick < this->Playback->Header().TickCount)
+            buttons = this->Playback->Input(this->PlaybackTick++);
+        else
         {
-            if (Paddle2->Position.y <= this->WindowHeight - Paddle2->Size.y)
-                Paddle2->Position.y += deltaSpace;
+            // End of the replay, hand control back to the keyboard
+            delete this->Playback;
+            this->Playback = nullptr;
         }
     }
-    if (this->State == GAME_MENU || this->State == GAME_WIN)
+    else if (this->Netplay != nullptr)
     {
-        if (this->Keys[GLFW_KEY_ENTER] && !this->KeysProcessed[GLFW_KEY_ENTER])
-        {
-            this->Reset();
-            this->State = GAME_ACTIVE;
-            this->KeysProcessed[GLFW_KEY_ENTER] = GL_TRUE;
-        }
+        // Either set of keys moves the local paddle, the session drops the other one's bits
+        if (buttons & (INPUT_PADDLE1_UP | INPUT_PADDLE2_UP))
+            buttons |= INPUT_PADDLE1_UP | INPUT_PADDLE2_UP;
+        if (buttons & (INPUT_PADDLE1_DOWN | INPUT_PADDLE2_DOWN))
+            buttons |= INPUT_PADDLE1_DOWN | INPUT_PADDLE2_DOWN;
+        // The session simulates the match itself, rolling back when the peer's input arrives
+        if (this->Netplay->AdvanceFrame(buttons))
+            this->Match = this->Netplay->State();
+        this->Update(deltaTime);
+        return;
+    }
+    else if (this->Bot != nullptr)
+    {
+        buttons &= ~(INPUT_PADDLE2_UP | INPUT_PADDLE2_DOWN);
+        buttons |= this->Bot->Decide(this->Match, deltaTime);
+    }
+    if (this->Recorder != nullptr)
+        this->Recorder->Record(this->Match, Particles->Pool.Rng.State, buttons);
+    this->Match.ProcessInput(buttons, deltaTime);
+    this->Update(deltaTime);
+}
+
+unsigned int Game::ProcessInput()
+{
+    // Translate the keyboard state into simulation buttons
+    unsigned int buttons = 0;
+    if (this->Keys[GLFW_KEY_W])
+        buttons |= INPUT_PADDLE1_UP;
+    if (this->Keys[GLFW_KEY_S])
+        buttons |= INPUT_PADDLE1_DOWN;
+    if (this->Keys[GLFW_KEY_UP])
+        buttons |= INPUT_PADDLE2_UP;
+    if (this->Keys[GLFW_KEY_DOWN])
+        buttons |= INPUT_PADDLE2_DOWN;
+    // Mode keys would change the match under a replay, and online games only
+    // take ENTER so as not to change it under the peer. Replays only capture
+    // Match, so there is no arena while recording.
+    bool replaying = this->Playback != nullptr;
+    bool modeKeys = !replaying && this->Netplay == nullptr;
+    if (!replaying && this->Match.State != GAME_ACTIVE && this->Keys[GLFW_KEY_ENTER] && !this->KeysProcessed[GLFW_KEY_ENTER])
+    {
+        delete this->Bot;
+        this->Bot = nullptr;
+        delete this->MultiBall;
+        this->MultiBall = nullptr;
+        buttons |= INPUT_START;
+        this->KeysProcessed[GLFW_KEY_ENTER] = GL_TRUE;
+    }
+    if (modeKeys && this->Match.State != GAME_ACTIVE && this->Keys[GLFW_KEY_1] && !this->KeysProcessed[GLFW_KEY_1])
+    {
+        delete this->Bot;
+        this->Bot = new AiController(PADDLE_RIGHT);
+        delete this->MultiBall;
+        this->MultiBall = nullptr;
+        buttons |= INPUT_START;
+        this->KeysProcessed[GLFW_KEY_1] = GL_TRUE;
+    }
+    if (modeKeys && this->Recorder == nullptr && this->Match.State != GAME_ACTIVE && this->Keys[GLFW_KEY_A] && !this->KeysProcessed[GLFW_KEY_A])
+    {
+        delete this->MultiBall;
+        this->MultiBall = new Arena(this->WindowWidth, this->WindowHeight);
+        this->MultiBall->Spawn(ARENA_BALL_COUNT);
+        buttons |= INPUT_START;
+        this->KeysProcessed[GLFW_KEY_A] = GL_TRUE;
     }
+    return buttons;
 }
 
 void Game::Update(GLfloat deltaTime)
 {
-    if (this->State == GAME_ACTIVE)
+    if (this->Match.State == GAME_ACTIVE && this->MultiBall != nullptr)
     {
-        // Update objects
-        Ball->Move(deltaTime, this->WindowHeight);
-        // Check for collisions
-        this->DoCollisions();
-        // Update particles
-        Particles->Update(deltaTime, *Ball, 2, glm::vec2(Ball->Radius / 2));
-        // Reduce shake time
-        if (ShakeTime > 0.0f)
+        // No sounds here: with thousands of balls something happens every tick
+        if (this->MultiBall->Update(deltaTime, this->Match.Paddle1, this->Match.Paddle2) & EVENT_PADDLE_HIT)
         {
-            ShakeTime -= deltaTime;
-            if (ShakeTime <= 0.0f)
-                Effects->Shake = false;
+            ShakeTime = 0.05f;
+            Effects->Shake = true;
         }
-        // Check loss condition
-        if (Ball->Position.x <= 0.0f)
+        // The arena keeps its own score; the match ends when it runs out
+        if (this->MultiBall->Paddle1Score >= ARENA_MAX_SCORE || this->MultiBall->Paddle2Score >= ARENA_MAX_SCORE)
+            this->Match.State = GAME_WIN;
+    }
+    else if (this->Match.State == GAME_ACTIVE || this->Netplay != nullptr)
+    {
+        // Advance the rules (an online session already did) and react to what happened
+        unsigned int events = this->Netplay != nullptr ? this->Netplay->Events : this->Match.Update(deltaTime);
+        if (events & EVENT_PADDLE_HIT)
         {
-            Paddle2Score++;
-            SoundEngine->play2D("../assets/out.wav", GL_FALSE);
-            Ball->Reset(glm::vec2(this->WindowWidth / 2, this->WindowHeight / 2), INITIAL_BALL_VELOCITY);
+            ShakeTime = 0.05f;
+            Effects->Shake = true;
+            SoundEngine->play2D("../assets/bleep.wav", GL_FALSE);
         }
-        else if (Ball->Position.x + Ball->Size.x >= this->WindowWidth)
+        if (events & (EVENT_PLAYER1_SCORED | EVENT_PLAYER2_SCORED))
         {
-            Paddle1Score++;
             SoundEngine->play2D("../assets/out.wav", GL_FALSE);
-            Ball->Reset(glm::vec2(this->WindowWidth / 2, this->WindowHeight / 2), INITIAL_BALL_VELOCITY);
+            // The ball was served again, don't interpolate across the court
+            this->PreviousMatch.Ball = this->Match.Ball;
         }
-
-        if (Paddle1Score >= MaxScore || Paddle2Score >= MaxScore)
-            this->State = GAME_WIN;
+        // Update particles
+        Particles->Update(deltaTime, this->Match.Ball, 2, glm::vec2(ToFloat(this->Match.Ball.Radius) / 2));
     }
-}
-
-void Game::Render()
-{
-    if (this->State == GAME_ACTIVE || this->State == GAME_MENU || this->State == GAME_WIN)
+    // Reduce shake time
+    if (ShakeTime > 0.0f)
     {
-        Effects->BeginRender();
-            Paddle1->Draw(*Renderer);
-            Paddle2->Draw(*Renderer);
-            Particles->Draw();
-            Ball->Draw(*Renderer);
-        Effects->EndRender();
-        Effects->Render(glfwGetTime());
-
-        std::stringstream ss;
-        ss << Paddle1Score << ":" << Paddle2Score;
-        Text->RenderText(ss.str(), this->WindowWidth / 2 - 45.0f, 5.0f, 1.0f);
-    }
-    if (this->State == GAME_MENU || this->State == GAME_WIN)
-        Text->RenderText("Press ENTER to start", 260.0f, this->WindowHeight / 2 - 25.0f, 0.5f);
-    if (this->State == GAME_WIN) {
-        std::string winText;
-        if (Paddle1Score > Paddle2Score)
-            winText = "Player 1 Won!";
-        else
-            winText = "Player 2 Won!";
-
-        Text->RenderText(winText, 270.0f, this->WindowHeight / 2 + 25.0f, 0.75f);
+        ShakeTime -= deltaTime;
+        if (ShakeTime <= 0.0f)
+            Effects->Shake = false;
     }
 }
 
-void Game::Reset()
+// Blend between the previous and current tick so motion stays smooth when the
+// frame rate and the simulation rate differ
+GameObject interpolate(const GameObject &previous, const GameObject &current, GLfloat alpha)
 {
-    Paddle1Score = 0;
-    Paddle2Score = 0;
-    Paddle1->Position = glm::vec2(10.0f, this->WindowHeight / 2 - PADDLE_SIZE.y / 2);
-    Paddle2->Position = glm::vec2(this->WindowWidth - PADDLE_SIZE.x - 10.0f, this->WindowHeight / 2 - PADDLE_SIZE.y / 2);
-    Ball->Reset(glm::vec2(this->WindowWidth / 2, this->WindowHeight / 2), INITIAL_BALL_VELOCITY);
+    GameObject object = current;
+    glm::vec2 from = ToGlm(previous.Position), to = ToGlm(current.Position);
+    object.Position = FromGlm(from + (to - from) * alpha);
+    return object;
 }
 
-// Collision detection
-GLboolean CheckCollision(GameObject &one, GameObject &two);
-
-void Game::DoCollisions()
+void Game::Render(GLfloat interpolation, double time)
 {
-    GLfloat strength = 2.0f;
-    glm::vec2 oldVelocity = Ball->Velocity;
-    if (CheckCollision(*Ball, *Paddle1))
+    GameState state = this->Match.State;
+    Text->BeginFrame();
+    if (state == GAME_ACTIVE || state == GAME_MENU || state == GAME_WIN)
     {
-        ShakeTime = 0.05f;
-        Effects->Shake = true;
-        SoundEngine->play2D("../assets/bleep.wav", GL_FALSE);
-
-        GLfloat centerBoard = Paddle1->Position.y + Paddle1->Size.y / 2;
-        GLfloat distance = (Ball->Position.y + Ball->Radius) - centerBoard;
-        GLfloat percentage = distance / (Paddle1->Size.y / 2);
-
-        Ball->Velocity.y = INITIAL_BALL_VELOCITY.y * percentage * strength;
-        Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
-        Ball->Velocity.x = -Ball->Velocity.x;
-        Ball->Position.x = Paddle1->Position.x + Paddle1->Size.x;
+        Effects->BeginRender();
+            if (this->MultiBall == nullptr)
+                Particles->Draw(*Frame);
+            Renderer->Begin();
+                Renderer->Submit(interpolate(this->PreviousMatch.Paddle1, this->Match.Paddle1, interpolation));
+                Renderer->Submit(interpolate(this->PreviousMatch.Paddle2, this->Match.Paddle2, interpolation));
+                if (this->MultiBall != nullptr)
+                {
+                    for (unsigned int i = 0; i < this->MultiBall->Count(); ++i)
+                    {
+                        GLfloat radius = this->MultiBall->Radius[i];
+                        Renderer->Submit(glm::vec2(this->MultiBall->PositionX[i] - radius, this->MultiBall->PositionY[i] - radius), glm::vec2(radius * 2));
+                    }
+                }
+                else
+                    Renderer->Submit(interpolate(this->PreviousMatch.Ball, this->Match.Ball, interpolation));
+            Renderer->Flush(*Frame);
+        Effects->EndRender(*Frame);
+        Effects->Render(*Frame);
+
+        // Formatted on the stack; the mesh is only rebuilt when the score changes
+        char score[32];
+        if (this->MultiBall != nullptr)
+            std::snprintf(score, sizeof(score), "%d:%d", this->MultiBall->Paddle1Score, this->MultiBall->Paddle2Score);
+        else
+            std::snprintf(score, sizeof(score), "%d:%d", this->Match.Paddle1Score, this->Match.Paddle2Score);
+        Text->SetText(ScoreText, score, this->WindowWidth / 2 - 45.0f, 5.0f, 1.0f);
+        Text->RenderText(*Frame, ScoreText);
     }
-    if (CheckCollision(*Ball, *Paddle2))
+    if (state == GAME_MENU || state == GAME_WIN)
     {
-        ShakeTime = 0.05f;
-        Effects->Shake = true;
-        SoundEngine->play2D("../assets/bleep.wav", GL_FALSE);
-
-        GLfloat centerBoard = Paddle2->Position.y + Paddle2->Size.y / 2;
-        GLfloat distance = (Ball->Position.y + Ball->Radius) - centerBoard;
-        GLfloat percentage = distance / (Paddle2->Size.y / 2);
-
-        Ball->Velocity.y = INITIAL_BALL_VELOCITY.y * percentage * strength;
-        Ball->Velocity = glm::normalize(Ball->Velocity) * glm::length(oldVelocity);
-        Ball->Velocity.x = -Ball->Velocity.x;
-        Ball->Position.x = Paddle2->Position.x - Ball->Size.x;
+        Text->RenderText(*Frame, StartText);
+        Text->RenderText(*Frame, ComputerText);
     }
-}
+    if (state == GAME_WIN) {
+        const char *winText;
+        bool player1Won = this->MultiBall != nullptr ? this->MultiBall->Paddle1Score > this->MultiBall->Paddle2Score
+                                                     : this->Match.Paddle1Score > this->Match.Paddle2Score;
+        if (player1Won)
+            winText = "Player 1 Won!";
+        else
+            winText = "Player 2 Won!";
 
-GLboolean CheckCollision(GameObject &one, GameObject &two) // AABB - AABB collision
-{
-    // Collision x-axis?
-    bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
-                      two.Position.x + two.Size.x >= one.Position.x;
-    // Collision y-axis?
-    bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
-                      two.Position.y + two.Size.y >= one.Position.y;
-    // Collision only if on both axes
-    return collisionX && collisionY;
+        Text->SetText(WinText, winText, 270.0f, this->WindowHeight / 2 + 25.0f, 0.75f);
+        Text->RenderText(*Frame, WinText);
+    }
+    // Per frame constants go up in one write, none if nothing changed...
+    FrameConstants->Data.Viewport = glm::vec2(this->FramebufferWidth, this->FramebufferHeight);
+    // Only chaos and shake read time, so it stands still while they are off
+    // and frames without effects leave the buffer alone. They only use it in
+    // periodic functions (period 2*PI): wrap it so the GLfloat uniform keeps
+    // its precision on long running instances
+    if (Effects->Chaos || Effects->Shake)
+        FrameConstants->Data.Time = static_cast<GLfloat>(std::fmod(time, EFFECTS_TIME_PERIOD));
+    FrameConstants->Data.Chaos = Effects->Chaos;
+    FrameConstants->Data.Confuse = Effects->Confuse;
+    FrameConstants->Data.Shake = Effects->Shake;
+    FrameConstants->Upload();
+    // ...then everything above, which was only queued, is drawn in state order
+    Frame->Execute();
 }
\ No newline at end of file
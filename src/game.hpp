@@ -6,22 +6,25 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
-enum GameState
-{
-    GAME_ACTIVE,
-    GAME_MENU,
-    GAME_WIN
-};
-
-const glm::vec2 PADDLE_SIZE(20, 100);
-const GLfloat PADDLE_VELOCITY(500.0f);
-const glm::vec2 INITIAL_BALL_VELOCITY(450.0f, 300.0f);
-const GLfloat BALL_RADIUS = 10.0f;
+#include "ai_controller.hpp"
+#include "arena.hpp"
+#include "replay.hpp"
+#include "rollback.hpp"
+#include "simulation.hpp"
+#include "udp_transport.hpp"
 
 class Game
 {
   public:
-    GameState State;
+    Simulation Match;
+    Simulation PreviousMatch; // State before the last tick, used to interpolate rendering
+    Arena *MultiBall;         // Multi-ball stress mode, started with A from the menu
+    AiController *Bot;        // Plays the right paddle in single player games
+    ReplayWriter *Recorder;   // Records every tick's input when set; only Match, so no arena meanwhile
+    ReplayReader *Playback;   // Replaces the keyboard input, mode keys included, when set
+    GLuint PlaybackTick;
+    UdpTransport *Connection; // Link to the other player in online games
+    RollbackSession *Netplay; // Simulates the match in online games
     GLboolean Keys[1024];
     GLboolean KeysProcessed[1024];
     GLuint WindowWidth, WindowHeight, FramebufferWidth, FramebufferHeight;
@@ -29,13 +32,19 @@ class Game
     Game(GLuint windowWidth, GLuint windowHeight, GLuint framebufferWidth, GLuint framebufferHeight);
     ~Game();
     
-    void Init();
-    void ProcessInput(GLfloat deltaTime);
-    void Update(GLfloat deltaTime);
-    void Render();
-    void DoCollisions();
+    // gpuParticles: simulate particles on the GPU with transform feedback
+    void Init(bool gpuParticles = false);
+    bool StartRecording(const std::string &file, GLfloat tickLength);
+    bool StartPlayback(const std::string &file);
+    // Online two-player game: with an empty host, waits for a peer on port and
+    // plays the left paddle, otherwise joins host:port and plays the right
+    // one. Both sides have to run at the same tick rate.
+    bool StartNetplay(const std::string &host, unsigned short port, GLfloat tickLength);
 
-    void Reset();
+    void Step(GLfloat deltaTime);
+    unsigned int ProcessInput();
+    void Update(GLfloat deltaTime);
+    void Render(GLfloat interpolation, double time);
 };
 
 #endif
\ No newline at end of file
@@ -1,23 +1,20 @@
 #ifndef GAMEOBJECT_H
 #define GAMEOBJECT_H
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "sprite_renderer.hpp"
+#include "numeric.hpp"
 
 class GameObject
 {
   public:
-    glm::vec2 Position, Size;
+    Vec2 Position, Size;
     glm::vec3 Color;
-    glm::vec2 Velocity;
-    GLfloat Rotation;
+    Vec2 Velocity;
+    float Rotation;
 
     GameObject();
-    GameObject(glm::vec2 pos, glm::vec2 size, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f));
-    
-    virtual void Draw(SpriteRenderer &renderer);
+    GameObject(Vec2 pos, Vec2 size, glm::vec3 color = glm::vec3(1.0f), Vec2 velocity = Vec2(0.0f, 0.0f));
 };
 
 #endif
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 #include "game.hpp"
 #include "resource_manager.hpp"
@@ -11,11 +15,53 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 const unsigned int WINDOW_WIDTH = 800;
 const unsigned int WINDOW_HEIGHT = 600;
+// Simulation ticks per second, can be changed with --tick-rate
+const double DEFAULT_TICK_RATE = 120.0;
+// Ticks simulated at most per frame; after a longer stall the backlog is dropped
+const int MAX_CATCH_UP_STEPS = 8;
 
 Game *Pong;
 
-int main()
+int main(int argc, char *argv[])
 {
+    double tickRate = DEFAULT_TICK_RATE;
+    const char *recordFile = nullptr;
+    const char *playFile = nullptr;
+    bool gpuParticles = false;
+    std::string netplayHost;
+    long netplayPort = -1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            tickRate = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "--play") == 0 && i + 1 < argc)
+            playFile = argv[++i];
+        else if (std::strcmp(argv[i], "--gpu-particles") == 0)
+            gpuParticles = true;
+        else if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+            netplayPort = std::strtol(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--join") == 0 && i + 1 < argc)
+        {
+            // HOST:PORT
+            netplayHost = argv[++i];
+            size_t colon = netplayHost.rfind(':');
+            netplayPort = colon != std::string::npos && colon > 0 ? std::strtol(netplayHost.c_str() + colon + 1, nullptr, 10) : 0;
+            netplayHost = netplayHost.substr(0, colon);
+        }
+        else
+            tickRate = 0.0;
+    }
+    // Online games are neither recorded nor replayed: the inputs are only final after rollbacks
+    bool netplay = netplayPort != -1;
+    if (tickRate <= 0.0 || (netplay && (netplayPort <= 0 || netplayPort > 65535 || recordFile != nullptr || playFile != nullptr)))
+    {
+        std::cout << "Usage: " << argv[0] << " [--tick-rate HZ] [--record FILE] [--play FILE] [--gpu-particles] [--host PORT | --join HOST:PORT]" << std::endl;
+        return -1;
+    }
+    double tickLength = 1.0 / tickRate;
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -49,26 +95,47 @@ int main()
     glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
     Pong = new Game(WINDOW_WIDTH, WINDOW_HEIGHT, framebufferWidth, framebufferHeight);
-    Pong->Init();
+    Pong->Init(gpuParticles);
+    if (playFile != nullptr && Pong->StartPlayback(playFile))
+        tickLength = Pong->Playback->Header().TickLength; // Replays only reproduce at their own tick rate
+    if (recordFile != nullptr)
+        Pong->StartRecording(recordFile, static_cast<GLfloat>(tickLength));
+    if (netplay && !Pong->StartNetplay(netplayHost, static_cast<unsigned short>(netplayPort), static_cast<GLfloat>(tickLength)))
+    {
+        glfwTerminate();
+        return -1;
+    }
 
-    GLfloat deltaTime = 0.0f;
-    GLfloat lastFrame = 0.0f;
+    // Fixed timestep: frames feed real time into the accumulator and the
+    // simulation consumes it in ticks of constant length. Time is kept as a
+    // 64-bit monotonic clock so it doesn't lose precision on long uptimes.
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point startTime = Clock::now();
+    Clock::time_point lastFrame = startTime;
+    double accumulator = 0.0;
 
     while (!glfwWindowShouldClose(window))
     {
-        GLfloat currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        Clock::time_point currentFrame = Clock::now();
+        accumulator += std::chrono::duration<double>(currentFrame - lastFrame).count();
         lastFrame = currentFrame;
         glfwPollEvents();
 
-        Pong->ProcessInput(deltaTime);
-
-        Pong->Update(deltaTime);
+        int steps = 0;
+        while (accumulator >= tickLength && steps < MAX_CATCH_UP_STEPS)
+        {
+            Pong->Step(static_cast<GLfloat>(tickLength));
+            accumulator -= tickLength;
+            steps++;
+        }
+        if (accumulator >= tickLength)
+            accumulator = 0.0;
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        Pong->Render();
+        double time = std::chrono::duration<double>(currentFrame - startTime).count();
+        Pong->Render(static_cast<GLfloat>(accumulator / tickLength), time);
 
         glfwSwapBuffers(window);
     }
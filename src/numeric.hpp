@@ -0,0 +1,36 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include <glm/glm.hpp>
+
+// Number types of the simulation state. The default build uses floats; with
+// PONG_FIXED_POINT defined the rules run on Q16.16 integers instead, so
+// lockstep peers and replays stay bit exact across compilers and CPUs.
+// Rendering and the bots keep working in floats through ToFloat/ToGlm.
+#ifdef PONG_FIXED_POINT
+
+#include "fixed_point.hpp"
+
+typedef Fixed Real;
+typedef FixedVec2 Vec2;
+const char NUMERIC_MODE_NAME[] = "fixed point (Q16.16)";
+
+inline float ToFloat(Real value) { return value.ToFloat(); }
+inline glm::vec2 ToGlm(const Vec2 &vector) { return glm::vec2(vector.x.ToFloat(), vector.y.ToFloat()); }
+inline Vec2 FromGlm(const glm::vec2 &vector) { return Vec2(vector.x, vector.y); }
+
+#else
+
+typedef float Real;
+typedef glm::vec2 Vec2;
+const char NUMERIC_MODE_NAME[] = "float";
+
+inline float ToFloat(Real value) { return value; }
+inline glm::vec2 ToGlm(const Vec2 &vector) { return vector; }
+inline Vec2 FromGlm(const glm::vec2 &vector) { return vector; }
+inline Real Length(const Vec2 &vector) { return glm::length(vector); }
+inline Vec2 Normalize(const Vec2 &vector) { return glm::normalize(vector); }
+
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include "particle_feedback.hpp"
+
+#include <algorithm>
+
+// One particle slot: position, velocity, brightness, alpha, life
+const GLuint PARTICLE_FLOATS = 7;
+const GLchar *const PARTICLE_FEEDBACK_VARYINGS[] = {"outPosition", "outVelocity", "outBrightness", "outAlpha", "outLife"};
+
+ParticleFeedback::ParticleFeedback(Shader render, Shader update, GLuint capacity)
+    : render(render), update(update), deltaTimeUniform(update.GetUniform("deltaTime")), fadeRateUniform(update.GetUniform("fadeRate")),
+      capacity(capacity), next(0), current(0), idle(PARTICLE_LIFE)
+{
+    GLfloat vertices[] = {
+        // Pos
+        0.0f, 1.0f,
+        1.0f, 0.0f,
+        0.0f, 0.0f,
+
+        0.0f, 1.0f,
+        1.0f, 1.0f,
+        1.0f, 0.0f};
+    glGenBuffers(1, &this->quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // Every slot starts expired (all zero)
+    std::vector<GLfloat> empty(capacity * PARTICLE_FLOATS, 0.0f);
+    GLsizei stride = PARTICLE_FLOATS * sizeof(GLfloat);
+    glGenBuffers(2, this->buffers);
+    glGenVertexArrays(2, this->updateVAOs);
+    glGenVertexArrays(2, this->renderVAOs);
+    for (int i = 0; i < 2; ++i)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, this->buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, empty.size() * sizeof(GLfloat), empty.data(), GL_DYNAMIC_COPY);
+
+        // Update pass input: the whole slot
+        glBindVertexArray(this->updateVAOs[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)(2 * sizeof(GLfloat)));
+        for (GLuint a = 2; a < 5; ++a)
+        {
+            glEnableVertexAttribArray(a);
+            glVertexAttribPointer(a, 1, GL_FLOAT, GL_FALSE, stride, (GLvoid *)((a + 2) * sizeof(GLfloat)));
+        }
+
+        // Render pass: the quad, plus offset x/y, brightness and alpha per instance (same layout as the CPU backend)
+        glBindVertexArray(this->renderVAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid *)0);
+        glBindBuffer(GL_ARRAY_BUFFER, this->buffers[i]);
+        GLuint offsets[] = {0, 1, 4, 5};
+        for (GLuint a = 0; a < 4; ++a)
+        {
+            glEnableVertexAttribArray(1 + a);
+            glVertexAttribPointer(1 + a, 1, GL_FLOAT, GL_FALSE, stride, (GLvoid *)(offsets[a] * sizeof(GLfloat)));
+            glVertexAttribDivisor(1 + a, 1);
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ParticleFeedback::~ParticleFeedback()
+{
+    glDeleteVertexArrays(2, this->updateVAOs);
+    glDeleteVertexArrays(2, this->renderVAOs);
+    glDeleteBuffers(2, this->buffers);
+    glDeleteBuffers(1, &this->quadVBO);
+}
+
+void ParticleFeedback::Spawn(const ParticlePool &staging)
+{
+    GLuint count = staging.Count();
+    if (count == 0 || this->capacity == 0)
+        return;
+    // More than fit: only the newest would survive the wrap around
+    GLuint first = count > this->capacity ? count - this->capacity : 0;
+    count -= first;
+    this->spawnData.resize(count * PARTICLE_FLOATS);
+    for (GLuint i = 0; i < count; ++i)
+    {
+        GLfloat *slot = &this->spawnData[i * PARTICLE_FLOATS];
+        slot[0] = staging.PositionX[first + i];
+        slot[1] = staging.PositionY[first + i];
+        slot[2] = staging.VelocityX[first + i];
+        slot[3] = staging.VelocityY[first + i];
+        slot[4] = staging.Brightness[first + i];
+        slot[5] = staging.Alpha[first + i];
+        slot[6] = staging.Life[first + i];
+    }
+    // At most two sub-updates: up to the end of the ring, then from its start
+    GLsizeiptr slotSize = PARTICLE_FLOATS * sizeof(GLfloat);
+    GLuint head = std::min(count, this->capacity - this->next);
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffers[this->current]);
+    glBufferSubData(GL_ARRAY_BUFFER, this->next * slotSize, head * slotSize, this->spawnData.data());
+    if (head < count)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (count - head) * slotSize, &this->spawnData[head * PARTICLE_FLOATS]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->next = (this->next + count) % this->capacity;
+    this->idle = 0.0f;
+}
+
+void ParticleFeedback::Update(GLfloat deltaTime)
+{
+    if (this->idle >= PARTICLE_LIFE)
+        return;
+    this->idle += deltaTime;
+    GLuint target = 1 - this->current;
+    this->update.Use();
+    this->update.SetFloat(this->deltaTimeUniform, deltaTime);
+    this->update.SetFloat(this->fadeRateUniform, PARTICLE_FADE_RATE);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(this->updateVAOs[this->current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->buffers[target]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, this->capacity);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    this->current = target;
+}
+
+void ParticleFeedback::Draw(RenderQueue &queue)
+{
+    if (this->idle >= PARTICLE_LIFE)
+        return;
+    GLuint capacity = this->capacity;
+    queue.Submit(RENDER_LAYER_PARTICLES, this->render.ID, 0, this->renderVAOs[this->current], BLEND_ADDITIVE, [capacity]() {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, capacity);
+    });
+}
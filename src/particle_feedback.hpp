@@ -0,0 +1,43 @@
+#ifndef PARTICLE_FEEDBACK_H
+#define PARTICLE_FEEDBACK_H
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "shader.hpp"
+#include "render_queue.hpp"
+#include "particle_pool.hpp"
+
+// Names of the update shader outputs, in buffer order
+extern const GLchar *const PARTICLE_FEEDBACK_VARYINGS[];
+const GLsizei PARTICLE_FEEDBACK_VARYING_COUNT = 5;
+
+// GPU particle backend. The particle state lives in two GL buffers and a
+// transform feedback pass advances it from one into the other, so the CPU
+// never touches existing particles. New particles are written into a ring of
+// slots (overwriting the oldest) with small glBufferSubData calls, and the
+// render pass instances the quad straight from the current buffer.
+class ParticleFeedback
+{
+  public:
+    ParticleFeedback(Shader render, Shader update, GLuint capacity);
+    ~ParticleFeedback();
+
+    // Copy the live particles of a staging pool into the next ring slots
+    void Spawn(const ParticlePool &staging);
+    void Update(GLfloat deltaTime);
+    void Draw(RenderQueue &queue);
+
+  private:
+    Shader render, update;
+    UniformHandle deltaTimeUniform, fadeRateUniform;
+    GLuint capacity;
+    GLuint next;    // Ring slot the next spawn goes to
+    GLuint current; // Buffer holding the latest state
+    GLfloat idle;   // Time since the last spawn; once every particle faded there is nothing to do
+    GLuint buffers[2], updateVAOs[2], renderVAOs[2];
+    GLuint quadVBO;
+    std::vector<GLfloat> spawnData;
+};
+
+#endif
@@ -1,55 +1,74 @@
 #include "particle_generator.hpp"
 
 ParticleGenerator::ParticleGenerator(Shader shader,  GLuint amount)
-    : amount(amount), shader(shader)
+    : Pool(amount), shader(shader), gpu(nullptr)
 {
     this->initRenderData();
 }
 
+ParticleGenerator::ParticleGenerator(Shader shader, Shader update, GLuint amount)
+    : Pool(amount), shader(shader), quadVAO(0), instanceVBO(0), gpu(new ParticleFeedback(shader, update, amount))
+{
+}
+
 ParticleGenerator::~ParticleGenerator()
 {
     glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->instanceVBO);
+    delete this->gpu;
 }
 
 void ParticleGenerator::Update(GLfloat deltaTime, GameObject &object, GLuint newParticles, glm::vec2 offset)
 {
-    // Add new particles
-    for (GLuint i = 0; i < newParticles; ++i)
+    if (this->gpu != nullptr)
     {
-        int unusedParticle = this->firstUnusedParticle();
-        this->respawnParticle(this->particles[unusedParticle], object, offset);
-    }
-    // Update all particles
-    for (GLuint i = 0; i < this->amount; ++i)
-    {
-        Particle &p = this->particles[i];
-        p.Life -= deltaTime; // reduce life
-        if (p.Life > 0.0f)
-        { // particle is alive, thus update
-            p.Position -= p.Velocity * deltaTime;
-            p.Color.a -= deltaTime * 2.5;
-        }
+        // Same spawn code (and random stream) as on the CPU, then off to the GPU
+        this->Pool.Clear();
+        this->Pool.Spawn(newParticles, ToGlm(object.Position), ToGlm(object.Velocity) * 0.1f, offset);
+        this->gpu->Spawn(this->Pool);
+        this->gpu->Update(deltaTime);
+        return;
     }
+    // Add new particles, they trail the object at a tenth of its speed
+    this->Pool.Spawn(newParticles, ToGlm(object.Position), ToGlm(object.Velocity) * 0.1f, offset);
+    // Update all particles, the expired ones are dropped on the way
+    this->Pool.Update(deltaTime);
 }
 
 void ParticleGenerator::Draw()
 {
-    // Use additive blending to give it a 'glow' effect
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    this->shader.Use();
-    for (Particle particle : this->particles)
+    RenderQueue queue;
+    this->Draw(queue);
+    queue.Execute();
+}
+
+void ParticleGenerator::Draw(RenderQueue &queue)
+{
+    if (this->gpu != nullptr)
     {
-        if (particle.Life > 0.0f)
-        {
-            this->shader.SetVector2f("offset", particle.Position);
-            this->shader.SetVector4f("color", particle.Color);
-            glBindVertexArray(this->quadVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-        }
+        this->gpu->Draw(queue);
+        return;
     }
-    // Don't forget to reset to default blending mode
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    const ParticlePool &pool = this->Pool;
+    GLuint count = pool.Count();
+    if (count == 0)
+        return;
+    // The live particles are packed at the front of each stream, so every
+    // stream goes up with a single copy into its region of the instance buffer
+    GLsizeiptr region = pool.Capacity() * sizeof(GLfloat);
+    GLsizeiptr used = count * sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, 4 * region, nullptr, GL_STREAM_DRAW); // Orphan last frame's data
+    glBufferSubData(GL_ARRAY_BUFFER, 0 * region, used, pool.PositionX.data());
+    glBufferSubData(GL_ARRAY_BUFFER, 1 * region, used, pool.PositionY.data());
+    glBufferSubData(GL_ARRAY_BUFFER, 2 * region, used, pool.Brightness.data());
+    glBufferSubData(GL_ARRAY_BUFFER, 3 * region, used, pool.Alpha.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Use additive blending to give it a 'glow' effect
+    queue.Submit(RENDER_LAYER_PARTICLES, this->shader.ID, 0, this->quadVAO, BLEND_ADDITIVE, [count]() {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+    });
 }
 
 void ParticleGenerator::initRenderData()
@@ -75,47 +94,18 @@ void ParticleGenerator::initRenderData()
     glBindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid *)0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    // Create this->amount default particle instances
-    for (GLuint i = 0; i < this->amount; ++i)
-        this->particles.push_back(Particle());
-}
 
-// Stores the index of the last particle used (for quick access to next dead particle)
-GLuint lastUsedParticle = 0;
-GLuint ParticleGenerator::firstUnusedParticle()
-{
-    // First search from last used particle, this will usually return almost instantly
-    for (GLuint i = lastUsedParticle; i < this->amount; ++i)
+    // Per instance attributes: offset x, offset y, brightness, alpha
+    GLsizeiptr region = this->Pool.Capacity() * sizeof(GLfloat);
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, 4 * region, nullptr, GL_STREAM_DRAW);
+    for (GLuint i = 0; i < 4; ++i)
     {
-        if (this->particles[i].Life <= 0.0f)
-        {
-            lastUsedParticle = i;
-            return i;
-        }
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, 1, GL_FLOAT, GL_FALSE, sizeof(GLfloat), (GLvoid *)(i * region));
+        glVertexAttribDivisor(1 + i, 1);
     }
-    // Otherwise, do a linear search
-    for (GLuint i = 0; i < lastUsedParticle; ++i)
-    {
-        if (this->particles[i].Life <= 0.0f)
-        {
-            lastUsedParticle = i;
-            return i;
-        }
-    }
-    // All particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-    lastUsedParticle = 0;
-    return 0;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
 }
-
-void ParticleGenerator::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
-{
-    GLfloat random = ((rand() % 100) - 50) / 10.0f;
-    GLfloat rColor = 0.5 + ((rand() % 100) / 100.0f);
-    particle.Position = object.Position + random + offset;
-    particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-    particle.Life = 1.0f;
-    particle.Velocity = object.Velocity * 0.1f;
-}
\ No newline at end of file
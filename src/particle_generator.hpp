@@ -6,36 +6,36 @@
 #include <glm/glm.hpp>
 
 #include "shader.hpp"
+#include "render_queue.hpp"
 #include "game_object.hpp"
-
-struct Particle
-{
-    glm::vec2 Position, Velocity;
-    glm::vec4 Color;
-    GLfloat Life;
-
-    Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) {}
-};
+#include "particle_pool.hpp"
+#include "particle_feedback.hpp"
 
 class ParticleGenerator
 {
   public:
+    // CPU backend: every live particle. GPU backend: only the particles
+    // spawned this update, on their way to the GL buffers.
+    ParticlePool Pool;
+
+    // CPU backend
     ParticleGenerator(Shader shader, GLuint amount);
+    // GPU backend, the particles are advanced by the transform feedback shader
+    ParticleGenerator(Shader shader, Shader update, GLuint amount);
     ~ParticleGenerator();
 
     void Update(GLfloat deltaTime, GameObject &object, GLuint newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
     void Draw();
+    // Queue the draw (additive, below the sprites) instead of drawing right away
+    void Draw(RenderQueue &queue);
 
   private:
-    std::vector<Particle> particles;
-    GLuint amount;
-    
     Shader shader;
     GLuint quadVAO;
+    GLuint instanceVBO; // Live particle streams, one region per attribute
+    ParticleFeedback *gpu;
 
     void initRenderData();
-    GLuint firstUnusedParticle();
-    void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
 };
 
 #endif
\ No newline at end of file
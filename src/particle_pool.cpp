@@ -0,0 +1,201 @@
+#include "particle_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_POOL_SSE2
+#include <emmintrin.h>
+#endif
+
+ParticlePool::ParticlePool(unsigned int capacity, uint32_t seed)
+    : PositionX(capacity), PositionY(capacity), VelocityX(capacity), VelocityY(capacity),
+      Brightness(capacity), Alpha(capacity), Life(capacity), Rng(seed), Workers(nullptr), live(0)
+{
+}
+
+// Seed of the random stream of one spawn chunk. The mix (murmur3 finalizer)
+// keeps neighbouring chunks from sharing parts of the same xorshift sequence.
+static uint32_t chunkSeed(uint32_t base, unsigned int chunk)
+{
+    uint32_t hash = base ^ (chunk * 0x9E3779B9u);
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+void ParticlePool::Spawn(unsigned int count, glm::vec2 position, glm::vec2 velocity, glm::vec2 offset)
+{
+    unsigned int room = this->Capacity() - this->live;
+    this->stats.Spawned += count;
+    if (count > room)
+    {
+        // Pool is full: the oldest particles are about to fade anyway, so
+        // keep them and drop the new ones (more particles should be reserved
+        // if this happens a lot)
+        this->stats.Dropped += count - room;
+        count = room;
+    }
+    if (count == 0)
+        return;
+    // Two random values per particle (position jitter and brightness), drawn
+    // in chunks so big bursts can be generated in parallel
+    this->randomValues.resize(count * 2);
+    uint32_t base = this->Rng.Next();
+    unsigned int first = this->live;
+    unsigned int chunks = (count + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE;
+    for (unsigned int c = 0; c < chunks; ++c)
+    {
+        unsigned int start = c * PARTICLE_CHUNK_SIZE;
+        unsigned int size = std::min(PARTICLE_CHUNK_SIZE, count - start);
+        uint32_t seed = chunkSeed(base, c);
+        if (this->Workers != nullptr && count >= PARTICLE_PARALLEL_THRESHOLD)
+            this->Workers->Submit([=]() { this->spawnChunk(first, start, size, seed, position, velocity, offset); });
+        else
+            this->spawnChunk(first, start, size, seed, position, velocity, offset);
+    }
+    if (this->Workers != nullptr && count >= PARTICLE_PARALLEL_THRESHOLD)
+        this->Workers->Wait();
+    this->live += count;
+    if (this->live > this->stats.Peak)
+        this->stats.Peak = this->live;
+}
+
+void ParticlePool::spawnChunk(unsigned int first, unsigned int start, unsigned int count, uint32_t seed,
+                              glm::vec2 position, glm::vec2 velocity, glm::vec2 offset)
+{
+    uint32_t *values = &this->randomValues[start * 2];
+    Random rng(seed);
+    rng.Fill(values, count * 2);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int index = first + start + i;
+        float jitter = ((values[2 * i] % 100) - 50.0f) / 10.0f;
+        this->PositionX[index] = position.x + jitter + offset.x;
+        this->PositionY[index] = position.y + jitter + offset.y;
+        this->VelocityX[index] = velocity.x;
+        this->VelocityY[index] = velocity.y;
+        this->Brightness[index] = 0.5f + (values[2 * i + 1] % 100) / 100.0f;
+        this->Alpha[index] = 1.0f;
+        this->Life[index] = PARTICLE_LIFE;
+    }
+}
+
+void ParticlePool::Update(float deltaTime)
+{
+    if (this->Workers == nullptr || this->live < PARTICLE_PARALLEL_THRESHOLD)
+    {
+        this->live = UpdateParticles(this->PositionX.data(), this->PositionY.data(), this->VelocityX.data(), this->VelocityY.data(),
+                                     this->Brightness.data(), this->Alpha.data(), this->Life.data(), 0, this->live, deltaTime);
+        return;
+    }
+    // Every chunk is integrated and packed in place by a worker...
+    unsigned int chunks = (this->live + PARTICLE_CHUNK_SIZE - 1) / PARTICLE_CHUNK_SIZE;
+    this->chunkSurvivors.resize(chunks);
+    for (unsigned int c = 0; c < chunks; ++c)
+    {
+        this->Workers->Submit([this, c, deltaTime]() {
+            unsigned int first = c * PARTICLE_CHUNK_SIZE;
+            unsigned int count = std::min(PARTICLE_CHUNK_SIZE, this->live - first);
+            this->chunkSurvivors[c] = UpdateParticles(this->PositionX.data(), this->PositionY.data(), this->VelocityX.data(), this->VelocityY.data(),
+                                                      this->Brightness.data(), this->Alpha.data(), this->Life.data(), first, count, deltaTime);
+        });
+    }
+    this->Workers->Wait();
+    // ...then the survivors slide down to close the gaps between chunks, one
+    // stream per task. Everything stays in the streams Draw uploads from.
+    float *streams[] = {this->PositionX.data(), this->PositionY.data(), this->VelocityX.data(), this->VelocityY.data(),
+                        this->Brightness.data(), this->Alpha.data(), this->Life.data()};
+    for (float *stream : streams)
+    {
+        this->Workers->Submit([this, stream, chunks]() {
+            unsigned int write = this->chunkSurvivors[0];
+            for (unsigned int c = 1; c < chunks; ++c)
+            {
+                if (write != c * PARTICLE_CHUNK_SIZE)
+                    std::memmove(stream + write, stream + c * PARTICLE_CHUNK_SIZE, this->chunkSurvivors[c] * sizeof(float));
+                write += this->chunkSurvivors[c];
+            }
+        });
+    }
+    this->Workers->Wait();
+    unsigned int survivors = 0;
+    for (unsigned int c = 0; c < chunks; ++c)
+        survivors += this->chunkSurvivors[c];
+    this->live = survivors;
+}
+
+// Single pass: integrate a block, then write the survivors back at the
+// compaction cursor. The cursor never overtakes the read position, so a block
+// is always loaded before anything is stored over it.
+unsigned int UpdateParticles(float *positionX, float *positionY, float *velocityX, float *velocityY,
+                             float *brightness, float *alpha, float *life, unsigned int first, unsigned int count,
+                             float deltaTime)
+{
+    const float fade = deltaTime * PARTICLE_FADE_RATE;
+    unsigned int write = first;
+    unsigned int i = first;
+    unsigned int end = first + count;
+#ifdef PARTICLE_POOL_SSE2
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 fades = _mm_set1_ps(fade);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 streams[7];
+        streams[4] = _mm_loadu_ps(velocityX + i);
+        streams[5] = _mm_loadu_ps(velocityY + i);
+        streams[0] = _mm_sub_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(streams[4], dt));
+        streams[1] = _mm_sub_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(streams[5], dt));
+        streams[2] = _mm_loadu_ps(brightness + i);
+        streams[3] = _mm_sub_ps(_mm_loadu_ps(alpha + i), fades);
+        streams[6] = _mm_sub_ps(_mm_loadu_ps(life + i), dt);
+        int alive = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(streams[6], zero), _mm_cmpgt_ps(streams[3], zero)));
+        float *outputs[7] = {positionX, positionY, brightness, alpha, velocityX, velocityY, life};
+        if (alive == 0xF)
+        {
+            for (int s = 0; s < 7; ++s)
+                _mm_storeu_ps(outputs[s] + write, streams[s]);
+            write += 4;
+        }
+        else if (alive != 0)
+        {
+            float lanes[7][4];
+            for (int s = 0; s < 7; ++s)
+                _mm_storeu_ps(lanes[s], streams[s]);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (!(alive & (1 << lane)))
+                    continue;
+                for (int s = 0; s < 7; ++s)
+                    outputs[s][write] = lanes[s][lane];
+                write++;
+            }
+        }
+    }
+#endif
+    // Scalar path (and SIMD tail), same operations in the same order
+    for (; i < end; ++i)
+    {
+        float remaining = life[i] - deltaTime;
+        float a = alpha[i] - fade;
+        if (!(remaining > 0.0f && a > 0.0f))
+            continue;
+        float x = positionX[i] - velocityX[i] * deltaTime;
+        float y = positionY[i] - velocityY[i] * deltaTime;
+        float vx = velocityX[i], vy = velocityY[i];
+        float b = brightness[i];
+        positionX[write] = x;
+        positionY[write] = y;
+        velocityX[write] = vx;
+        velocityY[write] = vy;
+        brightness[write] = b;
+        alpha[write] = a;
+        life[write] = remaining;
+        write++;
+    }
+    return write - first;
+}
@@ -0,0 +1,78 @@
+#ifndef PARTICLE_POOL_H
+#define PARTICLE_POOL_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "random.hpp"
+#include "thread_pool.hpp"
+
+const float PARTICLE_LIFE = 1.0f;
+// Alpha fades faster than life runs out: a particle is culled as soon as it is
+// invisible, which is well before its life is over
+const float PARTICLE_FADE_RATE = 2.5f;
+// Work is split in chunks of this many particles, each spawn chunk with its own
+// random stream: the result doesn't depend on the number of threads
+const unsigned int PARTICLE_CHUNK_SIZE = 16384;
+// Below this many particles a single thread is faster than handing out work
+const unsigned int PARTICLE_PARALLEL_THRESHOLD = 2 * PARTICLE_CHUNK_SIZE;
+
+// How hard an emitter pushes against its pool size
+struct ParticlePoolStats
+{
+    unsigned long long Spawned; // Particles emitted
+    unsigned long long Dropped; // Spawns lost because the pool was full
+    unsigned int Peak;          // Most particles alive at once
+
+    ParticlePoolStats() : Spawned(0), Dropped(0), Peak(0) {}
+};
+
+// Particles of one emitter as structure-of-arrays streams. The live particles
+// are always packed in [0, Count()), so updates and draws never visit dead
+// slots and the streams can be handed to SIMD code or GL buffers as they are.
+// Spawning appends after the last live particle, so it is O(1) and the pool
+// stays ordered by age.
+class ParticlePool
+{
+  public:
+    std::vector<float> PositionX, PositionY;
+    std::vector<float> VelocityX, VelocityY;
+    std::vector<float> Brightness, Alpha;
+    std::vector<float> Life;
+    Random Rng; // Own seedable stream so replays spawn the same particles
+    ThreadPool *Workers; // Optional, shares out large spawns and updates
+
+    explicit ParticlePool(unsigned int capacity, uint32_t seed = 1);
+
+    unsigned int Capacity() const { return static_cast<unsigned int>(this->Life.size()); }
+    unsigned int Count() const { return this->live; }
+    const ParticlePoolStats &Stats() const { return this->stats; }
+    void ResetStats() { this->stats = ParticlePoolStats(); }
+
+    // Emit particles around position (plus offset), all drifting with velocity.
+    // Once the pool is full further spawns are dropped (and counted).
+    void Spawn(unsigned int count, glm::vec2 position, glm::vec2 velocity, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // Age, move and fade every live particle, then drop the expired and the
+    // fully transparent ones
+    void Update(float deltaTime);
+    void Clear() { this->live = 0; }
+
+  private:
+    unsigned int live;
+    ParticlePoolStats stats;
+    std::vector<uint32_t> randomValues;
+    std::vector<unsigned int> chunkSurvivors;
+
+    void spawnChunk(unsigned int first, unsigned int start, unsigned int count, uint32_t seed,
+                    glm::vec2 position, glm::vec2 velocity, glm::vec2 offset);
+};
+
+// Integrates particles [first, first + count) and packs the survivors (life
+// and alpha left) starting at index first. Returns how many survived.
+unsigned int UpdateParticles(float *positionX, float *positionY, float *velocityX, float *velocityY,
+                             float *brightness, float *alpha, float *life, unsigned int first, unsigned int count,
+                             float deltaTime);
+
+#endif
@@ -1,10 +1,19 @@
 #include "post_processor.hpp"
 
+#include <algorithm>
 #include <iostream>
 
-PostProcessor::PostProcessor(Shader shader, GLuint width, GLuint height)
-    : PostProcessingShader(shader), Texture(), Width(width), Height(height), Confuse(GL_FALSE), Chaos(GL_FALSE), Shake(GL_FALSE)
+#include "resource_manager.hpp"
+
+PostProcessor::PostProcessor(GLuint width, GLuint height)
+    : Texture(), Width(width), Height(height), BlurDivisor(2), Confuse(GL_FALSE), Chaos(GL_FALSE), Shake(GL_FALSE)
 {
+    // The passes that draw to the screen move with the shake, the others don't
+    this->ChaosShader = ResourceManager::LoadShader("../src/shaders/post_processing.vs", "../src/shaders/post_chaos.fs", nullptr, "postprocessing_chaos");
+    this->ConfuseShader = ResourceManager::LoadShader("../src/shaders/post_processing.vs", "../src/shaders/post_confuse.fs", nullptr, "postprocessing_confuse");
+    this->BlurShaders[0] = ResourceManager::LoadShader("../src/shaders/post_pass.vs", "../src/shaders/post_blur.fs", nullptr, "postprocessing_blur_x");
+    this->BlurShaders[1] = ResourceManager::LoadShader("../src/shaders/post_processing.vs", "../src/shaders/post_blur.fs", nullptr, "postprocessing_blur_y");
+
     // Initialize renderbuffer/framebuffer object
     glGenFramebuffers(1, &this->MSFBO);
     glGenFramebuffers(1, &this->FBO);
@@ -28,73 +37,152 @@ PostProcessor::PostProcessor(Shader shader, GLuint width, GLuint height)
 
     // Initialize render data and uniforms
     this->initRenderData();
-    this->PostProcessingShader.SetInteger("scene", 0, GL_TRUE);
+    this->ChaosShader.SetInteger("scene", 0, GL_TRUE);
+    this->ConfuseShader.SetInteger("scene", 0, GL_TRUE);
+    // The 3x3 blur as two 3 tap passes, one across and one down. Offsets are
+    // in texture coordinates, so they don't depend on the pass resolution.
     GLfloat offset = 1.0f / 300.0f;
-    GLfloat offsets[9][2] = {
-        {-offset, offset},  // top-left
-        {0.0f, offset},     // top-center
-        {offset, offset},   // top-right
-        {-offset, 0.0f},    // center-left
-        {0.0f, 0.0f},       // center-center
-        {offset, 0.0f},     // center - right
-        {-offset, -offset}, // bottom-left
-        {0.0f, -offset},    // bottom-center
-        {offset, -offset}   // bottom-right
-    };
-    glUniform2fv(glGetUniformLocation(this->PostProcessingShader.ID, "offsets"), 9, (GLfloat *)offsets);
-    GLint edge_kernel[9] = {
-        -1, -1, -1,
-        -1, 8, -1,
-        -1, -1, -1};
-    glUniform1iv(glGetUniformLocation(this->PostProcessingShader.ID, "edge_kernel"), 9, edge_kernel);
-    GLfloat blur_kernel[9] = {
-        1.0 / 16, 2.0 / 16, 1.0 / 16,
-        2.0 / 16, 4.0 / 16, 2.0 / 16,
-        1.0 / 16, 2.0 / 16, 1.0 / 16};
-    glUniform1fv(glGetUniformLocation(this->PostProcessingShader.ID, "blur_kernel"), 9, blur_kernel);
+    this->BlurShaders[0].SetInteger("scene", 0, GL_TRUE);
+    this->BlurShaders[0].SetVector2f("direction", offset, 0.0f);
+    this->BlurShaders[1].SetInteger("scene", 0, GL_TRUE);
+    this->BlurShaders[1].SetVector2f("direction", 0.0f, offset);
 }
 
 PostProcessor::~PostProcessor()
 {
+    for (RenderTarget &target : this->targets)
+    {
+        glDeleteFramebuffers(1, &target.FBO);
+        glDeleteTextures(1, &target.Texture.ID);
+    }
+    glDeleteFramebuffers(1, &this->MSFBO);
+    glDeleteFramebuffers(1, &this->FBO);
+    glDeleteRenderbuffers(1, &this->RBO);
+    glDeleteTextures(1, &this->Texture.ID);
     glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
 }
 
 void PostProcessor::BeginRender()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, this->MSFBO);
+    // Targets are set up here: once the scene is being queued, the
+    // framebuffer binding must stay put until the queue runs
+    this->choosePasses();
+    glBindFramebuffer(GL_FRAMEBUFFER, this->passes.empty() ? 0 : this->MSFBO);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
+void PostProcessor::choosePasses()
+{
+    this->passes.clear();
+    // Chaos hides confuse and either one hides the shake's blur, while the
+    // shake itself moves whatever is drawn last
+    if (this->Chaos)
+        this->addPass(this->ChaosShader, 1);
+    else if (this->Confuse)
+        this->addPass(this->ConfuseShader, 1);
+    else if (this->Shake)
+    {
+        this->addPass(this->BlurShaders[0], this->BlurDivisor);
+        this->addPass(this->BlurShaders[1], 1);
+    }
+    // Each pass reads the previous one's target, the last one draws to the screen
+    GLuint source = this->Texture.ID;
+    for (size_t i = 0; i < this->passes.size(); ++i)
+    {
+        Pass &pass = this->passes[i];
+        pass.Source = source;
+        if (i + 1 == this->passes.size())
+        {
+            pass.FBO = 0;
+            pass.Width = this->Width;
+            pass.Height = this->Height;
+            continue;
+        }
+        const RenderTarget &target = this->target(pass.Divisor, source);
+        pass.FBO = target.FBO;
+        pass.Width = target.Texture.Width;
+        pass.Height = target.Texture.Height;
+        source = target.Texture.ID;
+    }
+}
+
+void PostProcessor::addPass(const Shader &program, GLuint divisor)
+{
+    Pass pass = {&program, divisor, 0, 0, 0, 0};
+    this->passes.push_back(pass);
+}
+
+// A target of that resolution other than the one being read: consecutive
+// passes ping-pong between two of them
+const PostProcessor::RenderTarget &PostProcessor::target(GLuint divisor, GLuint source)
+{
+    for (const RenderTarget &target : this->targets)
+        if (target.Divisor == divisor && target.Texture.ID != source)
+            return target;
+    RenderTarget target;
+    target.Divisor = divisor;
+    target.Texture.Wrap_S = GL_CLAMP_TO_EDGE;
+    target.Texture.Wrap_T = GL_CLAMP_TO_EDGE;
+    glGenFramebuffers(1, &target.FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+    target.Texture.Generate(std::max(this->Width / divisor, 1u), std::max(this->Height / divisor, 1u), NULL);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.Texture.ID, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::POSTPROCESSOR: Failed to initialize a pass target" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    this->targets.push_back(target);
+    return this->targets.back();
+}
+
 void PostProcessor::EndRender()
 {
-    // Now resolve multisampled color-buffer into intermediate FBO to store to texture
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
-    glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // Binds both READ and WRITE framebuffer to default framebuffer
+    RenderQueue queue;
+    this->EndRender(queue);
+    queue.Execute();
 }
 
-void PostProcessor::Render(GLfloat time)
+void PostProcessor::Render()
 {
-    // Set uniforms/options
-    this->PostProcessingShader.Use();
-    this->PostProcessingShader.SetFloat("time", time);
-    this->PostProcessingShader.SetInteger("confuse", this->Confuse);
-    this->PostProcessingShader.SetInteger("chaos", this->Chaos);
-    this->PostProcessingShader.SetInteger("shake", this->Shake);
-    // Render textured quad
-    glActiveTexture(GL_TEXTURE0);
-    this->Texture.Bind();
-    glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    RenderQueue queue;
+    this->Render(queue);
+    queue.Execute();
+}
+
+void PostProcessor::EndRender(RenderQueue &queue)
+{
+    // The scene is already on the screen
+    if (this->passes.empty())
+        return;
+    // Same state as the first pass, so the two run back to back without any switch
+    queue.Submit(RENDER_LAYER_POST_PROCESSING, 0, this->passes[0].Program->ID, this->Texture.ID, this->quadVAO, BLEND_ALPHA, [this]() {
+        // Now resolve multisampled color-buffer into intermediate FBO to store to texture
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->MSFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, this->FBO);
+        glBlitFramebuffer(0, 0, this->Width, this->Height, 0, 0, this->Width, this->Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0); // Binds both READ and WRITE framebuffer to default framebuffer
+    });
+}
+
+void PostProcessor::Render(RenderQueue &queue)
+{
+    // One step per pass, so they run in order after the resolve
+    for (size_t i = 0; i < this->passes.size(); ++i)
+    {
+        const Pass &pass = this->passes[i];
+        GLuint fbo = pass.FBO, width = pass.Width, height = pass.Height;
+        queue.Submit(RENDER_LAYER_POST_PROCESSING, static_cast<unsigned int>(i + 1), pass.Program->ID, pass.Source, this->quadVAO, BLEND_ALPHA, [fbo, width, height]() {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(0, 0, width, height);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        });
+    }
 }
 
 void PostProcessor::initRenderData()
 {
     // Configure VAO/VBO
-    GLuint VBO;
     GLfloat vertices[] = {
         // Pos        // Tex
         -1.0f, -1.0f, 0.0f, 0.0f,
@@ -105,9 +193,9 @@ void PostProcessor::initRenderData()
         1.0f, -1.0f, 1.0f, 0.0f,
         1.0f, 1.0f, 1.0f, 1.0f};
     glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &this->quadVBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     glBindVertexArray(this->quadVAO);
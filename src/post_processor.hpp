@@ -1,34 +1,69 @@
 #ifndef POST_PROCESSOR_H
 #define POST_PROCESSOR_H
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "sprite_renderer.hpp"
 #include "shader.hpp"
+#include "render_queue.hpp"
 
+// Post processing as a chain of full screen passes, one per effect. Each pass
+// reads what the previous one wrote (the scene first) into a ping-pong
+// target, and the last one draws to the screen. Effects that are off have no
+// pass; with none on, the scene is drawn straight to the screen, skipping the
+// multisampled buffer and its resolve altogether.
 class PostProcessor
 {
   public:
-    Shader PostProcessingShader;
-    Texture2D Texture;
+    Shader ChaosShader, ConfuseShader;
+    Shader BlurShaders[2]; // Horizontal, then vertical
+    Texture2D Texture;     // The resolved scene
     GLuint Width, Height;
-    
+    GLuint BlurDivisor; // The horizontal blur runs at 1/BlurDivisor resolution (2 by default)
+
     GLboolean Confuse, Chaos, Shake;
-    
-    PostProcessor(Shader shader, GLuint width, GLuint height);
+
+    PostProcessor(GLuint width, GLuint height);
     ~PostProcessor();
-    
+
+    // Binds where the scene is drawn: the multisampled buffer when an effect
+    // is on, the screen otherwise. The effects can't change until Render.
     void BeginRender();
     void EndRender();
-    void Render(GLfloat time);
+    // The effect flags and time are read from the FrameData uniform block
+    void Render();
+    // Queued versions, drawn in the post processing layer after the scene
+    void EndRender(RenderQueue &queue);
+    void Render(RenderQueue &queue);
 
   private:
+    struct RenderTarget
+    {
+        GLuint FBO;
+        Texture2D Texture;
+        GLuint Divisor; // Of the screen size
+    };
+    struct Pass
+    {
+        const Shader *Program;
+        GLuint Divisor;       // Resolution of its target; the last pass draws to the screen
+        GLuint Source;        // Texture it reads
+        GLuint FBO;           // Where it draws
+        GLuint Width, Height; // Viewport
+    };
+
     GLuint MSFBO, FBO; // MSFBO = Multisampled FBO. FBO is regular, used for blitting MS color-buffer to texture
     GLuint RBO;        // RBO is used for multisampled color buffer
-    GLuint quadVAO;
-    
+    GLuint quadVAO, quadVBO;
+    std::vector<RenderTarget> targets; // Made the first time a pass needs them
+    std::vector<Pass> passes;          // This frame's, chosen by BeginRender
+
     void initRenderData();
+    void choosePasses();
+    void addPass(const Shader &program, GLuint divisor);
+    const RenderTarget &target(GLuint divisor, GLuint source);
 };
 
 #endif
\ No newline at end of file
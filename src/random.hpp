@@ -0,0 +1,47 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Small, fast and seedable xorshift32 generator. Unlike rand() every owner has
+// its own stream, which keeps simulations reproducible and independent.
+class Random
+{
+  public:
+    uint32_t State;
+
+    explicit Random(uint32_t seed = 2463534242u) : State(seed != 0 ? seed : 2463534242u) {}
+
+    uint32_t Next()
+    {
+        this->State ^= this->State << 13;
+        this->State ^= this->State >> 17;
+        this->State ^= this->State << 5;
+        return this->State;
+    }
+    // Batch version of Next(), for hot loops that need many values at once
+    void Fill(uint32_t *values, unsigned int count)
+    {
+        uint32_t state = this->State;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            values[i] = state;
+        }
+        this->State = state;
+    }
+    // Uniform float in [0, 1)
+    float NextFloat()
+    {
+        return (this->Next() >> 8) * (1.0f / 16777216.0f);
+    }
+    // Uniform float in [min, max)
+    float Range(float min, float max)
+    {
+        return min + (max - min) * this->NextFloat();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+
+uint64_t RenderQueue::Key(RenderLayer layer, unsigned int step, GLuint program, GLuint texture, BlendMode blend)
+{
+    // layer:8 | step:8 | program:16 | texture:16 | blend:8 | unused:8. GL
+    // names are small integers; should one ever get past 16 bits it only
+    // groups worse.
+    return (static_cast<uint64_t>(layer & 0xFF) << 56) |
+           (static_cast<uint64_t>(step & 0xFF) << 48) |
+           (static_cast<uint64_t>(program & 0xFFFF) << 32) |
+           (static_cast<uint64_t>(texture & 0xFFFF) << 16) |
+           (static_cast<uint64_t>(blend & 0xFF) << 8);
+}
+
+void RenderQueue::Submit(RenderLayer layer, GLuint program, GLuint texture, GLuint vertexArray, BlendMode blend, std::function<void()> draw)
+{
+    this->Submit(layer, 0, program, texture, vertexArray, blend, std::move(draw));
+}
+
+void RenderQueue::Submit(RenderLayer layer, unsigned int step, GLuint program, GLuint texture, GLuint vertexArray, BlendMode blend, std::function<void()> draw)
+{
+    RenderCommand command = {program, texture, vertexArray, blend, std::move(draw)};
+    this->order.push_back(std::make_pair(Key(layer, step, program, texture, blend), static_cast<unsigned int>(this->commands.size())));
+    this->commands.push_back(std::move(command));
+}
+
+void RenderQueue::Execute()
+{
+    this->stats = RenderQueueStats();
+    // Ties on the key fall back to the index: submission order
+    std::sort(this->order.begin(), this->order.end());
+    // Anything may have been bound since the last frame, except the blend
+    // mode, which is always put back to the default
+    GLuint program = 0, texture = 0, vertexArray = 0;
+    BlendMode blend = BLEND_ALPHA;
+    bool first = true;
+    glActiveTexture(GL_TEXTURE0);
+    for (const std::pair<uint64_t, unsigned int> &entry : this->order)
+    {
+        const RenderCommand &command = this->commands[entry.second];
+        if (first || command.Program != program)
+        {
+            glUseProgram(command.Program);
+            program = command.Program;
+            this->stats.StateChanges++;
+        }
+        if (command.Texture != 0 && (first || command.Texture != texture))
+        {
+            glBindTexture(GL_TEXTURE_2D, command.Texture);
+            texture = command.Texture;
+            this->stats.StateChanges++;
+        }
+        if (first || command.VertexArray != vertexArray)
+        {
+            glBindVertexArray(command.VertexArray);
+            vertexArray = command.VertexArray;
+            this->stats.StateChanges++;
+        }
+        if (command.Blend != blend)
+        {
+            if (command.Blend == BLEND_ADDITIVE)
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            else
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            blend = command.Blend;
+            this->stats.StateChanges++;
+        }
+        first = false;
+        command.Draw();
+    }
+    this->stats.Commands = static_cast<unsigned int>(this->commands.size());
+    if (blend != BLEND_ALPHA)
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    this->commands.clear();
+    this->order.clear();
+}
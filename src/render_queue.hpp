@@ -0,0 +1,70 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Layers are drawn in this order. Inside a layer the commands are grouped by
+// state, so only things whose relative order doesn't matter (not overlapping,
+// or blended commutatively) may share a layer.
+enum RenderLayer
+{
+    RENDER_LAYER_PARTICLES,
+    RENDER_LAYER_SPRITES,
+    RENDER_LAYER_POST_PROCESSING,
+    RENDER_LAYER_HUD
+};
+
+enum BlendMode
+{
+    BLEND_ALPHA,   // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA (the default)
+    BLEND_ADDITIVE // GL_SRC_ALPHA, GL_ONE
+};
+
+// One draw and the state it needs. The queue binds the program, the texture
+// (unit 0, 0 means none needed), the vertex array and the blend mode, so Draw
+// only issues the draw call and must leave those bindings alone.
+struct RenderCommand
+{
+    GLuint Program, Texture, VertexArray;
+    BlendMode Blend;
+    std::function<void()> Draw;
+};
+
+// What the last Execute did
+struct RenderQueueStats
+{
+    unsigned int Commands;
+    unsigned int StateChanges; // Program, texture, vertex array and blend switches
+
+    RenderQueueStats() : Commands(0), StateChanges(0) {}
+};
+
+// The frame as a list of commands. Execute sorts them by a 64 bit key
+// (layer, step, program, texture, blend) and only touches GL state that
+// actually changes between neighbours. Commands with equal keys keep their
+// submission order.
+class RenderQueue
+{
+  public:
+    static uint64_t Key(RenderLayer layer, unsigned int step, GLuint program, GLuint texture, BlendMode blend);
+
+    void Submit(RenderLayer layer, GLuint program, GLuint texture, GLuint vertexArray, BlendMode blend, std::function<void()> draw);
+    // Inside a layer, commands of a later step run after all those of the
+    // earlier ones (step 0 above), for passes that read what others drew
+    void Submit(RenderLayer layer, unsigned int step, GLuint program, GLuint texture, GLuint vertexArray, BlendMode blend, std::function<void()> draw);
+    // Draw everything submitted so far and empty the queue
+    void Execute();
+    const RenderQueueStats &Stats() const { return this->stats; }
+
+  private:
+    std::vector<RenderCommand> commands;
+    std::vector<std::pair<uint64_t, unsigned int>> order; // Key, index in commands
+    RenderQueueStats stats;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "replay.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ReplayKeyframe CaptureKeyframe(uint32_t tick, const Simulation &match, uint32_t particleSeed)
+{
+    ReplayKeyframe keyframe;
+    keyframe.Tick = tick;
+    keyframe.State = match.State;
+    keyframe.Paddle1Score = match.Paddle1Score;
+    keyframe.Paddle2Score = match.Paddle2Score;
+    keyframe.Paddle1Position[0] = match.Paddle1.Position.x;
+    keyframe.Paddle1Position[1] = match.Paddle1.Position.y;
+    keyframe.Paddle2Position[0] = match.Paddle2.Position.x;
+    keyframe.Paddle2Position[1] = match.Paddle2.Position.y;
+    keyframe.BallPosition[0] = match.Ball.Position.x;
+    keyframe.BallPosition[1] = match.Ball.Position.y;
+    keyframe.BallVelocity[0] = match.Ball.Velocity.x;
+    keyframe.BallVelocity[1] = match.Ball.Velocity.y;
+    keyframe.ParticleSeed = particleSeed;
+    return keyframe;
+}
+
+void RestoreKeyframe(const ReplayKeyframe &keyframe, Simulation &match)
+{
+    match.State = static_cast<GameState>(keyframe.State);
+    match.Paddle1Score = keyframe.Paddle1Score;
+    match.Paddle2Score = keyframe.Paddle2Score;
+    match.Paddle1.Position = Vec2(keyframe.Paddle1Position[0], keyframe.Paddle1Position[1]);
+    match.Paddle2.Position = Vec2(keyframe.Paddle2Position[0], keyframe.Paddle2Position[1]);
+    match.Ball.Position = Vec2(keyframe.BallPosition[0], keyframe.BallPosition[1]);
+    match.Ball.Velocity = Vec2(keyframe.BallVelocity[0], keyframe.BallVelocity[1]);
+}
+
+ReplayWriter::ReplayWriter()
+    : header()
+{
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    this->Close();
+}
+
+bool ReplayWriter::Open(const std::string &file, unsigned int width, unsigned int height, float tickLength, uint32_t keyframeInterval)
+{
+    this->Close();
+    this->stream.open(file.c_str(), std::ios::binary | std::ios::trunc);
+    if (!this->stream)
+    {
+        std::cout << "ERROR::REPLAY: Failed to open " << file << " for writing" << std::endl;
+        return false;
+    }
+    std::memcpy(this->header.Magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    this->header.Version = REPLAY_VERSION;
+    this->header.NumericFormat = REPLAY_NUMERIC_FORMAT;
+    this->header.Width = width;
+    this->header.Height = height;
+    this->header.TickLength = tickLength;
+    this->header.KeyframeInterval = keyframeInterval > 0 ? keyframeInterval : REPLAY_KEYFRAME_INTERVAL;
+    this->header.TickCount = 0;
+    // Tick count is patched in on Close
+    this->stream.write(reinterpret_cast<const char *>(&this->header), sizeof(this->header));
+    return true;
+}
+
+void ReplayWriter::Record(const Simulation &match, uint32_t particleSeed, unsigned int buttons)
+{
+    if (!this->stream.is_open())
+        return;
+    uint32_t tick = this->header.TickCount++;
+    if (tick % this->header.KeyframeInterval == 0)
+    {
+        ReplayKeyframe keyframe = CaptureKeyframe(tick, match, particleSeed);
+        this->stream.write(reinterpret_cast<const char *>(&keyframe), sizeof(keyframe));
+    }
+    this->stream.put(static_cast<char>(buttons & 0xFF));
+}
+
+void ReplayWriter::Close()
+{
+    if (!this->stream.is_open())
+        return;
+    // Pad the last chunk so every chunk has the same size
+    uint32_t partial = this->header.TickCount % this->header.KeyframeInterval;
+    if (partial != 0)
+        for (uint32_t i = partial; i < this->header.KeyframeInterval; ++i)
+            this->stream.put(0);
+    this->stream.seekp(0);
+    this->stream.write(reinterpret_cast<const char *>(&this->header), sizeof(this->header));
+    this->stream.close();
+}
+
+ReplayReader::ReplayReader()
+    : data(nullptr), size(0), header()
+{
+}
+
+ReplayReader::~ReplayReader()
+{
+    this->Close();
+}
+
+bool ReplayReader::Open(const std::string &file)
+{
+    this->Close();
+#ifdef _WIN32
+    std::ifstream stream(file.c_str(), std::ios::binary);
+    this->buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+#else
+    int descriptor = open(file.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        std::cout << "ERROR::REPLAY: Failed to open " << file << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED)
+        {
+            this->data = static_cast<const unsigned char *>(mapping);
+            this->size = info.st_size;
+            // Playback reads front to back
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+        }
+    }
+    close(descriptor);
+#endif
+    if (this->size < sizeof(ReplayHeader))
+    {
+        std::cout << "ERROR::REPLAY: " << file << " is not a replay" << std::endl;
+        this->Close();
+        return false;
+    }
+    std::memcpy(&this->header, this->data, sizeof(ReplayHeader));
+    if (std::memcmp(this->header.Magic, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 || this->header.Version != REPLAY_VERSION ||
+        this->header.KeyframeInterval == 0 || this->chunkOffset(this->KeyframeCount()) > this->size)
+    {
+        std::cout << "ERROR::REPLAY: " << file << " is not a valid replay" << std::endl;
+        this->Close();
+        return false;
+    }
+    if (this->header.NumericFormat != REPLAY_NUMERIC_FORMAT)
+    {
+        std::cout << "ERROR::REPLAY: " << file << " was recorded with a different numeric mode" << std::endl;
+        this->Close();
+        return false;
+    }
+    return true;
+}
+
+void ReplayReader::Close()
+{
+#ifdef _WIN32
+    this->buffer.clear();
+#else
+    if (this->data != nullptr)
+        munmap(const_cast<unsigned char *>(this->data), this->size);
+#endif
+    this->data = nullptr;
+    this->size = 0;
+    this->header = ReplayHeader();
+}
+
+size_t ReplayReader::chunkOffset(uint32_t chunk) const
+{
+    return sizeof(ReplayHeader) + static_cast<size_t>(chunk) * (sizeof(ReplayKeyframe) + this->header.KeyframeInterval);
+}
+
+uint32_t ReplayReader::KeyframeCount() const
+{
+    return (this->header.TickCount + this->header.KeyframeInterval - 1) / this->header.KeyframeInterval;
+}
+
+unsigned int ReplayReader::Input(uint32_t tick) const
+{
+    uint32_t chunk = tick / this->header.KeyframeInterval;
+    return this->data[this->chunkOffset(chunk) + sizeof(ReplayKeyframe) + tick % this->header.KeyframeInterval];
+}
+
+ReplayKeyframe ReplayReader::Keyframe(uint32_t index) const
+{
+    // Records aren't necessarily aligned in the file, copy out
+    ReplayKeyframe keyframe;
+    std::memcpy(&keyframe, this->data + this->chunkOffset(index), sizeof(keyframe));
+    return keyframe;
+}
+
+void ReplayReader::Seek(uint32_t tick, Simulation &match, uint32_t &particleSeed) const
+{
+    if (this->KeyframeCount() == 0)
+        return;
+    if (tick > this->header.TickCount)
+        tick = this->header.TickCount;
+    uint32_t chunk = tick / this->header.KeyframeInterval;
+    if (chunk >= this->KeyframeCount())
+        chunk = this->KeyframeCount() - 1;
+    ReplayKeyframe keyframe = this->Keyframe(chunk);
+    RestoreKeyframe(keyframe, match);
+    // Particles are cosmetic and not re-simulated, they restart from the keyframe's seed
+    particleSeed = keyframe.ParticleSeed;
+    for (uint32_t t = keyframe.Tick; t < tick; ++t)
+    {
+        match.ProcessInput(this->Input(t), this->header.TickLength);
+        match.Update(this->header.TickLength);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "simulation.hpp"
+
+// Replay file layout (little endian, fixed size records):
+//
+//   ReplayHeader
+//   chunk 0: ReplayKeyframe (state before tick 0)       + KeyframeInterval input bytes
+//   chunk 1: ReplayKeyframe (state before tick K)       + KeyframeInterval input bytes
+//   ...
+//
+// Every chunk has the same size, so both the input of any tick and the
+// keyframe preceding it are found with a single offset computation.
+const char REPLAY_MAGIC[8] = {'P', 'O', 'N', 'G', 'R', 'P', 'L', '1'};
+const uint32_t REPLAY_VERSION = 4;
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 600;
+// Keyframes store the simulation numbers as they are, so a replay only loads
+// in a build using the same numeric mode (see numeric.hpp)
+#ifdef PONG_FIXED_POINT
+const uint32_t REPLAY_NUMERIC_FORMAT = 1;
+#else
+const uint32_t REPLAY_NUMERIC_FORMAT = 0;
+#endif
+
+struct ReplayHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t NumericFormat;
+    uint32_t Width, Height;
+    float TickLength;
+    uint32_t KeyframeInterval;
+    uint32_t TickCount;
+};
+
+// Full simulation state at the start of a tick
+struct ReplayKeyframe
+{
+    uint32_t Tick;
+    int32_t State;
+    int32_t Paddle1Score, Paddle2Score;
+    Real Paddle1Position[2], Paddle2Position[2];
+    Real BallPosition[2], BallVelocity[2];
+    uint32_t ParticleSeed;
+};
+
+ReplayKeyframe CaptureKeyframe(uint32_t tick, const Simulation &match, uint32_t particleSeed);
+void RestoreKeyframe(const ReplayKeyframe &keyframe, Simulation &match);
+
+class ReplayWriter
+{
+  public:
+    ReplayWriter();
+    ~ReplayWriter();
+
+    bool Open(const std::string &file, unsigned int width, unsigned int height, float tickLength,
+              uint32_t keyframeInterval = REPLAY_KEYFRAME_INTERVAL);
+    // Record the buttons of the next tick, together with the state they are applied to
+    void Record(const Simulation &match, uint32_t particleSeed, unsigned int buttons);
+    void Close();
+
+  private:
+    std::ofstream stream;
+    ReplayHeader header;
+};
+
+// Reads a replay through a read-only memory mapping, so even multi-hour
+// sessions open instantly and pages are only loaded when touched
+class ReplayReader
+{
+  public:
+    ReplayReader();
+    ~ReplayReader();
+
+    bool Open(const std::string &file);
+    void Close();
+
+    const ReplayHeader &Header() const { return this->header; }
+    unsigned int Input(uint32_t tick) const;
+    ReplayKeyframe Keyframe(uint32_t index) const;
+    uint32_t KeyframeCount() const;
+    // Restore the state at the start of the given tick: nearest keyframe, then re-simulate
+    void Seek(uint32_t tick, Simulation &match, uint32_t &particleSeed) const;
+
+  private:
+    const unsigned char *data;
+    size_t size;
+    ReplayHeader header;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;
+#endif
+
+    size_t chunkOffset(uint32_t chunk) const;
+};
+
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "resource_manager.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -10,6 +12,8 @@
 // Instantiate static variables
 std::map<std::string, Texture2D> ResourceManager::Textures;
 std::map<std::string, Shader> ResourceManager::Shaders;
+std::map<std::string, AtlasRegion> ResourceManager::Regions;
+std::vector<std::pair<std::string, std::string>> ResourceManager::atlasFiles;
 
 Shader ResourceManager::LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, std::string name)
 {
@@ -17,6 +21,12 @@ Shader ResourceManager::LoadShader(const GLchar *vShaderFile, const GLchar *fSha
     return Shaders[name];
 }
 
+Shader ResourceManager::LoadFeedbackShader(const GLchar *vShaderFile, const GLchar *const *varyings, GLsizei count, std::string name)
+{
+    Shaders[name] = loadShaderFromFile(vShaderFile, nullptr, nullptr, varyings, count);
+    return Shaders[name];
+}
+
 Shader ResourceManager::GetShader(std::string name)
 {
     return Shaders[name];
@@ -33,6 +43,105 @@ Texture2D ResourceManager::GetTexture(std::string name)
     return Textures[name];
 }
 
+void ResourceManager::AddToAtlas(const GLchar *file, std::string name)
+{
+    atlasFiles.push_back(std::make_pair(name, std::string(file)));
+}
+
+// Copy an image into a page, repeating its edge pixels into the padding
+static void blitPadded(std::vector<unsigned char> &page, GLuint pageSize, const unsigned char *image,
+                       GLuint width, GLuint height, GLuint x, GLuint y)
+{
+    GLint padding = ATLAS_PADDING;
+    for (GLint row = -padding; row < static_cast<GLint>(height) + padding; ++row)
+    {
+        GLint sourceRow = std::min(std::max(row, 0), static_cast<GLint>(height) - 1);
+        for (GLint column = -padding; column < static_cast<GLint>(width) + padding; ++column)
+        {
+            GLint sourceColumn = std::min(std::max(column, 0), static_cast<GLint>(width) - 1);
+            std::memcpy(&page[((y + row) * pageSize + x + column) * 4], &image[(sourceRow * width + sourceColumn) * 4], 4);
+        }
+    }
+}
+
+void ResourceManager::BuildAtlas(GLuint pageSize)
+{
+    struct Image
+    {
+        std::string Name;
+        unsigned char *Pixels;
+        int Width, Height;
+    };
+    std::vector<Image> images;
+    for (const std::pair<std::string, std::string> &entry : atlasFiles)
+    {
+        Image image;
+        image.Name = entry.first;
+        int channels;
+        image.Pixels = stbi_load(entry.second.c_str(), &image.Width, &image.Height, &channels, 4); // Always RGBA
+        if (image.Pixels == nullptr)
+        {
+            std::cout << "ERROR::ATLAS: Failed to load " << entry.second << std::endl;
+            continue;
+        }
+        if (image.Width + 2 * ATLAS_PADDING > pageSize || image.Height + 2 * ATLAS_PADDING > pageSize)
+        {
+            std::cout << "ERROR::ATLAS: " << entry.second << " is larger than an atlas page" << std::endl;
+            stbi_image_free(image.Pixels);
+            continue;
+        }
+        images.push_back(image);
+    }
+    atlasFiles.clear();
+    // Tallest first, so the shelves fill up evenly
+    std::stable_sort(images.begin(), images.end(), [](const Image &a, const Image &b) { return a.Height > b.Height; });
+
+    ShelfPacker packer(pageSize, pageSize);
+    std::vector<unsigned char> pixels(pageSize * pageSize * 4, 0);
+    std::vector<std::string> pageRegions; // Regions waiting for their page texture
+    auto finishPage = [&]() {
+        Texture2D page;
+        page.Internal_Format = GL_RGBA;
+        page.Image_Format = GL_RGBA;
+        page.Wrap_S = GL_CLAMP_TO_EDGE;
+        page.Wrap_T = GL_CLAMP_TO_EDGE;
+        page.Generate(pageSize, pageSize, pixels.data());
+        std::stringstream name;
+        name << "atlas" << page.ID;
+        Textures[name.str()] = page;
+        for (const std::string &region : pageRegions)
+            Regions[region].Texture = page.ID;
+        pageRegions.clear();
+        packer.Reset();
+        std::fill(pixels.begin(), pixels.end(), 0);
+    };
+    for (const Image &image : images)
+    {
+        GLuint x, y;
+        if (!packer.Pack(image.Width, image.Height, x, y))
+        {
+            finishPage();
+            packer.Pack(image.Width, image.Height, x, y); // Always fits an empty page
+        }
+        blitPadded(pixels, pageSize, image.Pixels, image.Width, image.Height, x, y);
+        AtlasRegion region;
+        GLfloat size = static_cast<GLfloat>(pageSize);
+        region.UV = glm::vec4(x / size, y / size, (x + image.Width) / size, (y + image.Height) / size);
+        region.Width = image.Width;
+        region.Height = image.Height;
+        Regions[image.Name] = region;
+        pageRegions.push_back(image.Name);
+        stbi_image_free(image.Pixels);
+    }
+    if (!pageRegions.empty())
+        finishPage();
+}
+
+AtlasRegion ResourceManager::GetRegion(std::string name)
+{
+    return Regions[name];
+}
+
 void ResourceManager::Clear()
 {
     // (Properly) delete all shaders
@@ -43,7 +152,8 @@ void ResourceManager::Clear()
         glDeleteTextures(1, &iter.second.ID);
 }
 
-Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile)
+Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile,
+                                           const GLchar *const *varyings, GLsizei count)
 {
     // 1. Retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -53,17 +163,22 @@ Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLch
     {
         // Open files
         std::ifstream vertexShaderFile(vShaderFile);
-        std::ifstream fragmentShaderFile(fShaderFile);
-        std::stringstream vShaderStream, fShaderStream;
+        std::stringstream vShaderStream;
         // Read file's buffer contents into streams
         vShaderStream << vertexShaderFile.rdbuf();
-        fShaderStream << fragmentShaderFile.rdbuf();
         // close file handlers
         vertexShaderFile.close();
-        fragmentShaderFile.close();
         // Convert stream into string
         vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        // Transform feedback programs have no fragment shader
+        if (fShaderFile != nullptr)
+        {
+            std::ifstream fragmentShaderFile(fShaderFile);
+            std::stringstream fShaderStream;
+            fShaderStream << fragmentShaderFile.rdbuf();
+            fragmentShaderFile.close();
+            fragmentCode = fShaderStream.str();
+        }
         // If geometry shader path is present, also load a geometry shader
         if (gShaderFile != nullptr)
         {
@@ -83,7 +198,8 @@ Shader ResourceManager::loadShaderFromFile(const GLchar *vShaderFile, const GLch
     const GLchar *gShaderCode = geometryCode.c_str();
     // 2. Now create shader object from source code
     Shader shader;
-    shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+    shader.Compile(vShaderCode, fShaderFile != nullptr ? fShaderCode : nullptr, gShaderFile != nullptr ? gShaderCode : nullptr,
+                   varyings, count);
     return shader;
 }
 
@@ -101,5 +217,6 @@ Texture2D ResourceManager::loadTextureFromFile(const GLchar *file, GLboolean alp
     unsigned char *image = stbi_load(file, &width, &height, &nrChannels, 0);
     // Now generate texture
     texture.Generate(width, height, image);
+    stbi_image_free(image);
     return texture;
 }
\ No newline at end of file
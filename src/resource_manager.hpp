@@ -3,10 +3,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 
 #include "texture.hpp"
+#include "texture_atlas.hpp"
 #include "shader.hpp"
 
 class ResourceManager
@@ -14,17 +16,28 @@ class ResourceManager
   public:
     static std::map<std::string, Shader> Shaders;
     static std::map<std::string, Texture2D> Textures;
+    static std::map<std::string, AtlasRegion> Regions;
     
     static Shader LoadShader(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile, std::string name);
+    // Vertex only program whose outputs are captured with transform feedback
+    static Shader LoadFeedbackShader(const GLchar *vShaderFile, const GLchar *const *varyings, GLsizei count, std::string name);
     static Shader GetShader(std::string name);
     static Texture2D LoadTexture(const GLchar *file, GLboolean alpha, std::string name);
     static Texture2D GetTexture(std::string name);
+    // Images added to the atlas are only loaded by BuildAtlas, which packs
+    // them all into as few RGBA pages as it can (stored as atlas textures).
+    // Their regions then share a texture, so they batch together.
+    static void AddToAtlas(const GLchar *file, std::string name);
+    static void BuildAtlas(GLuint pageSize = ATLAS_PAGE_SIZE);
+    static AtlasRegion GetRegion(std::string name);
     static void Clear();
 
   private:
     ResourceManager() {}
-    static Shader loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile = nullptr);
+    static Shader loadShaderFromFile(const GLchar *vShaderFile, const GLchar *fShaderFile, const GLchar *gShaderFile = nullptr,
+                                     const GLchar *const *varyings = nullptr, GLsizei count = 0);
     static Texture2D loadTextureFromFile(const GLchar *file, GLboolean alpha);
+    static std::vector<std::pair<std::string, std::string>> atlasFiles; // Name, file
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "rollback.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Simulation>::value, "Rollback saves and restores Simulation by plain copy");
+
+LoopbackNetwork::LoopbackNetwork(unsigned int latency, unsigned int jitter, float loss, uint32_t seed)
+    : Latency(latency), Jitter(jitter), Loss(loss), Sent(0), Dropped(0), random(seed), now(0)
+{
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        this->endpoints[i].network = this;
+        this->endpoints[i].index = i;
+    }
+}
+
+void LoopbackEndpoint::Send(const InputPacket &packet)
+{
+    LoopbackNetwork &network = *this->network;
+    network.Sent++;
+    if (network.random.NextFloat() < network.Loss)
+    {
+        network.Dropped++;
+        return;
+    }
+    LoopbackNetwork::InFlight inFlight;
+    inFlight.DeliverAt = network.now + network.Latency + (network.Jitter > 0 ? network.random.Next() % (network.Jitter + 1) : 0);
+    inFlight.Packet = packet;
+    network.inboxes[1 - this->index].push_back(inFlight);
+}
+
+bool LoopbackEndpoint::Receive(InputPacket &packet)
+{
+    std::vector<LoopbackNetwork::InFlight> &inbox = this->network->inboxes[this->index];
+    for (size_t i = 0; i < inbox.size(); ++i)
+    {
+        if (inbox[i].DeliverAt > this->network->now)
+            continue;
+        // Jitter reorders packets, like a real network would
+        packet = inbox[i].Packet;
+        inbox[i] = inbox.back();
+        inbox.pop_back();
+        return true;
+    }
+    return false;
+}
+
+RollbackSession::RollbackSession(const Simulation &initial, PaddleSide localSide, Transport &transport, float tickLength)
+    : LocalSide(localSide), Tick(0), RemoteConfirmed(0), Rollbacks(0), ResimulatedTicks(0), Stalls(0), Events(EVENT_NONE),
+      transport(transport), tickLength(tickLength), current(initial),
+      states(MAX_ROLLBACK_TICKS, initial), remoteAck(0)
+{
+}
+
+unsigned int RollbackSession::localMask() const
+{
+    if (this->LocalSide == PADDLE_LEFT)
+        return INPUT_PADDLE1_UP | INPUT_PADDLE1_DOWN | INPUT_START;
+    return INPUT_PADDLE2_UP | INPUT_PADDLE2_DOWN | INPUT_START;
+}
+
+bool RollbackSession::AdvanceFrame(unsigned int localButtons)
+{
+    this->Events = EVENT_NONE;
+    this->receive();
+    if (this->Tick > this->RemoteConfirmed && this->Tick - this->RemoteConfirmed >= MAX_ROLLBACK_TICKS - 1)
+    {
+        // Can't predict further without losing the state to roll back to
+        this->Stalls++;
+        this->send();
+        return false;
+    }
+
+    this->localInputs.push_back(static_cast<uint8_t>(localButtons & this->localMask()));
+    if (this->remoteInputs.size() <= this->Tick)
+        this->remoteInputs.push_back(this->RemoteConfirmed > 0 ? this->remoteInputs[this->RemoteConfirmed - 1] : 0);
+    this->Events = this->simulate(this->Tick);
+    this->Tick++;
+
+    // States up to the first tick with an unconfirmed input are final now
+    uint32_t settled = std::min(this->RemoteConfirmed, this->Tick - 1);
+    while (this->ConfirmedHashes.size() <= settled)
+        this->ConfirmedHashes.push_back(this->states[this->ConfirmedHashes.size() % MAX_ROLLBACK_TICKS].Hash());
+
+    this->send();
+    return true;
+}
+
+unsigned int RollbackSession::simulate(uint32_t tick)
+{
+    this->states[tick % MAX_ROLLBACK_TICKS] = this->current;
+    unsigned int buttons = this->localInputs[tick] | (this->remoteInputs[tick] & ~this->localMask());
+    buttons |= this->remoteInputs[tick] & INPUT_START;
+    this->current.ProcessInput(buttons, this->tickLength);
+    return this->current.Update(this->tickLength);
+}
+
+void RollbackSession::receive()
+{
+    uint32_t rollbackFrom = this->Tick;
+    InputPacket packet;
+    while (this->transport.Receive(packet))
+    {
+        // It can't have more of our ticks than we simulated, whatever the packet says
+        this->remoteAck = std::max(this->remoteAck, std::min(packet.Ack, this->Tick));
+        // Inputs are only taken in order, older packets just repeat what we have
+        if (packet.FirstTick > this->RemoteConfirmed || packet.FirstTick + packet.Count <= this->RemoteConfirmed)
+            continue;
+        for (uint32_t t = this->RemoteConfirmed; t < packet.FirstTick + packet.Count; ++t)
+        {
+            uint8_t buttons = packet.Buttons[t - packet.FirstTick];
+            if (t < this->Tick)
+            {
+                if (this->remoteInputs[t] != buttons)
+                    rollbackFrom = std::min(rollbackFrom, t);
+                this->remoteInputs[t] = buttons;
+            }
+            else
+                this->remoteInputs.push_back(buttons);
+        }
+        this->RemoteConfirmed = packet.FirstTick + packet.Count;
+    }
+    if (rollbackFrom >= this->Tick)
+        return;
+
+    // A prediction was wrong: restore and simulate again, predicting from the newest input
+    this->Rollbacks++;
+    this->ResimulatedTicks += this->Tick - rollbackFrom;
+    this->current = this->states[rollbackFrom % MAX_ROLLBACK_TICKS];
+    for (uint32_t t = rollbackFrom; t < this->Tick; ++t)
+    {
+        if (t >= this->RemoteConfirmed)
+            this->remoteInputs[t] = this->remoteInputs[this->RemoteConfirmed - 1];
+        this->simulate(t);
+    }
+}
+
+void RollbackSession::send()
+{
+    InputPacket packet = InputPacket();
+    packet.Ack = this->RemoteConfirmed;
+    packet.FirstTick = this->remoteAck;
+    packet.Count = std::min(this->Tick - this->remoteAck, MAX_ROLLBACK_TICKS);
+    for (uint32_t i = 0; i < packet.Count; ++i)
+        packet.Buttons[i] = this->localInputs[packet.FirstTick + i];
+    this->transport.Send(packet);
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ai_controller.hpp"
+#include "random.hpp"
+#include "simulation.hpp"
+
+// How far a peer may run ahead of the last input confirmed by the other one
+const unsigned int MAX_ROLLBACK_TICKS = 16;
+
+// Local inputs from FirstTick on, resent until the other peer acknowledged them
+struct InputPacket
+{
+    uint32_t Ack;       // Number of the receiver's ticks the sender already has
+    uint32_t FirstTick;
+    uint32_t Count;
+    uint8_t Buttons[MAX_ROLLBACK_TICKS];
+};
+
+// Unreliable, unordered packet delivery between two peers
+class Transport
+{
+  public:
+    virtual ~Transport() {}
+    virtual void Send(const InputPacket &packet) = 0;
+    virtual bool Receive(InputPacket &packet) = 0;
+};
+
+class LoopbackNetwork;
+
+// One side of a LoopbackNetwork
+class LoopbackEndpoint : public Transport
+{
+  public:
+    LoopbackEndpoint() : network(nullptr), index(0) {}
+
+    void Send(const InputPacket &packet);
+    bool Receive(InputPacket &packet);
+
+  private:
+    friend class LoopbackNetwork;
+    LoopbackNetwork *network;
+    unsigned int index;
+};
+
+// In-process network between two endpoints with configurable latency, jitter
+// and packet loss, all in ticks and driven by Advance() for reproducible tests
+class LoopbackNetwork
+{
+  public:
+    unsigned int Latency, Jitter; // In ticks
+    float Loss;                   // Probability of dropping a packet
+    unsigned int Sent, Dropped;
+
+    LoopbackNetwork(unsigned int latency, unsigned int jitter = 0, float loss = 0.0f, uint32_t seed = 1);
+
+    Transport &Endpoint(unsigned int index) { return this->endpoints[index]; }
+    void Advance() { this->now++; }
+
+  private:
+    friend class LoopbackEndpoint;
+    struct InFlight
+    {
+        uint64_t DeliverAt;
+        InputPacket Packet;
+    };
+
+    LoopbackEndpoint endpoints[2];
+    std::vector<InFlight> inboxes[2];
+    Random random;
+    uint64_t now;
+};
+
+// GGPO style session: the simulation never waits for the remote input. It is
+// predicted (last known input repeated), and when the real input arrives and
+// differs, the state is restored from the ring of saved ticks and the ticks
+// since are simulated again. Saving and restoring is a plain copy of the
+// trivially copyable Simulation.
+class RollbackSession
+{
+  public:
+    PaddleSide LocalSide;
+    uint32_t Tick;             // Next tick to simulate
+    uint32_t RemoteConfirmed;  // Remote inputs of ticks [0, RemoteConfirmed) are known
+    unsigned int Rollbacks, ResimulatedTicks, Stalls;
+    unsigned int Events; // Simulation events of the tick AdvanceFrame last simulated
+    std::vector<uint64_t> ConfirmedHashes; // Hash of the final state at the start of each tick
+
+    RollbackSession(const Simulation &initial, PaddleSide localSide, Transport &transport, float tickLength);
+
+    // Simulates one tick with the given local buttons, or returns false without
+    // advancing if this peer got too far ahead of the remote one
+    bool AdvanceFrame(unsigned int localButtons);
+    const Simulation &State() const { return this->current; }
+
+  private:
+    Transport &transport;
+    float tickLength;
+    Simulation current;
+    std::vector<Simulation> states;        // State at the start of tick t, at t % MAX_ROLLBACK_TICKS
+    std::vector<uint8_t> localInputs;
+    std::vector<uint8_t> remoteInputs;     // Confirmed or predicted
+    uint32_t remoteAck;                    // Local ticks the remote peer has
+
+    unsigned int localMask() const;
+    unsigned int simulate(uint32_t tick);
+    void receive();
+    void send();
+};
+
+#endif
\ No newline at end of file
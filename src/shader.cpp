@@ -1,5 +1,6 @@
 #include "shader.hpp"
 
+#include <cstring>
 #include <iostream>
 
 Shader &Shader::Use()
@@ -8,19 +9,23 @@ Shader &Shader::Use()
     return *this;
 }
 
-void Shader::Compile(const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource)
+void Shader::Compile(const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource,
+                     const GLchar *const *feedbackVaryings, GLsizei feedbackCount)
 {
-    GLuint sVertex, sFragment, gShader;
+    GLuint sVertex, sFragment = 0, gShader;
     // Vertex Shader
     sVertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(sVertex, 1, &vertexSource, NULL);
     glCompileShader(sVertex);
     checkCompileErrors(sVertex, "VERTEX");
     // Fragment Shader
-    sFragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(sFragment, 1, &fragmentSource, NULL);
-    glCompileShader(sFragment);
-    checkCompileErrors(sFragment, "FRAGMENT");
+    if (fragmentSource != nullptr)
+    {
+        sFragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(sFragment, 1, &fragmentSource, NULL);
+        glCompileShader(sFragment);
+        checkCompileErrors(sFragment, "FRAGMENT");
+    }
     // If geometry shader source code is given, also compile geometry shader
     if (geometrySource != nullptr)
     {
@@ -32,71 +37,165 @@ void Shader::Compile(const GLchar *vertexSource, const GLchar *fragmentSource, c
     // Shader Program
     this->ID = glCreateProgram();
     glAttachShader(this->ID, sVertex);
-    glAttachShader(this->ID, sFragment);
+    if (fragmentSource != nullptr)
+        glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
+    // Captured outputs have to be declared before linking
+    if (feedbackVaryings != nullptr)
+        glTransformFeedbackVaryings(this->ID, feedbackCount, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
     // Delete the shaders as they're linked into our program now and no longer necessery
     glDeleteShader(sVertex);
-    glDeleteShader(sFragment);
+    if (fragmentSource != nullptr)
+        glDeleteShader(sFragment);
     if (geometrySource != nullptr)
         glDeleteShader(gShader);
+    GLuint frameData = glGetUniformBlockIndex(this->ID, "FrameData");
+    if (frameData != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->ID, frameData, FRAME_DATA_BINDING);
+    this->readUniforms();
+}
+
+static unsigned int hashName(const GLchar *name)
+{
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; ++name)
+        hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+    return hash;
+}
+
+void Shader::readUniforms()
+{
+    this->uniforms = std::make_shared<ShaderUniforms>();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> name(maxLength + 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(this->ID, i, static_cast<GLsizei>(name.size()), nullptr, &size, &type, name.data());
+        ShaderUniforms::Entry entry;
+        entry.Name = name.data();
+        // Arrays are reported as "name[0]", they are set by their plain name
+        if (entry.Name.size() > 3 && entry.Name.compare(entry.Name.size() - 3, 3, "[0]") == 0)
+            entry.Name.resize(entry.Name.size() - 3);
+        entry.Hash = hashName(entry.Name.c_str());
+        entry.Location = glGetUniformLocation(this->ID, entry.Name.c_str());
+        entry.Set = false;
+        if (entry.Location >= 0) // Uniform block members have no location
+            this->uniforms->Entries.push_back(entry);
+    }
+}
+
+UniformHandle Shader::GetUniform(const GLchar *name) const
+{
+    if (!this->uniforms)
+        return UniformHandle();
+    unsigned int hash = hashName(name);
+    const std::vector<ShaderUniforms::Entry> &entries = this->uniforms->Entries;
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (entries[i].Hash == hash && entries[i].Name == name)
+            return UniformHandle(static_cast<GLint>(i));
+    return UniformHandle();
+}
+
+bool Shader::changed(UniformHandle uniform, const void *value, size_t size)
+{
+    if (!uniform.Valid())
+        return false;
+    ShaderUniforms::Entry &entry = this->uniforms->Entries[uniform.Index];
+    if (entry.Set && std::memcmp(entry.Value, value, size) == 0)
+        return false;
+    std::memcpy(entry.Value, value, size);
+    entry.Set = true;
+    return true;
 }
 
 void Shader::SetFloat(const GLchar *name, GLfloat value, GLboolean useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    this->SetFloat(this->GetUniform(name), value, useShader);
 }
 void Shader::SetInteger(const GLchar *name, GLint value, GLboolean useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    this->SetInteger(this->GetUniform(name), value, useShader);
 }
 void Shader::SetVector2f(const GLchar *name, GLfloat x, GLfloat y, GLboolean useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    this->SetVector2f(this->GetUniform(name), glm::vec2(x, y), useShader);
 }
 void Shader::SetVector2f(const GLchar *name, const glm::vec2 &value, GLboolean useShader)
+{
+    this->SetVector2f(this->GetUniform(name), value, useShader);
+}
+void Shader::SetVector3f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLboolean useShader)
+{
+    this->SetVector3f(this->GetUniform(name), glm::vec3(x, y, z), useShader);
+}
+void Shader::SetVector3f(const GLchar *name, const glm::vec3 &value, GLboolean useShader)
+{
+    this->SetVector3f(this->GetUniform(name), value, useShader);
+}
+void Shader::SetVector4f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLfloat w, GLboolean useShader)
+{
+    this->SetVector4f(this->GetUniform(name), glm::vec4(x, y, z, w), useShader);
+}
+void Shader::SetVector4f(const GLchar *name, const glm::vec4 &value, GLboolean useShader)
+{
+    this->SetVector4f(this->GetUniform(name), value, useShader);
+}
+void Shader::SetMatrix4(const GLchar *name, const glm::mat4 &matrix, GLboolean useShader)
+{
+    this->SetMatrix4(this->GetUniform(name), matrix, useShader);
+}
+
+void Shader::SetFloat(UniformHandle uniform, GLfloat value, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    if (this->changed(uniform, &value, sizeof(value)))
+        glUniform1f(this->uniforms->Entries[uniform.Index].Location, value);
 }
-void Shader::SetVector3f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLboolean useShader)
+void Shader::SetInteger(UniformHandle uniform, GLint value, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    if (this->changed(uniform, &value, sizeof(value)))
+        glUniform1i(this->uniforms->Entries[uniform.Index].Location, value);
 }
-void Shader::SetVector3f(const GLchar *name, const glm::vec3 &value, GLboolean useShader)
+void Shader::SetVector2f(UniformHandle uniform, const glm::vec2 &value, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    GLfloat values[2] = {value.x, value.y};
+    if (this->changed(uniform, values, sizeof(values)))
+        glUniform2f(this->uniforms->Entries[uniform.Index].Location, value.x, value.y);
 }
-void Shader::SetVector4f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLfloat w, GLboolean useShader)
+void Shader::SetVector3f(UniformHandle uniform, const glm::vec3 &value, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    GLfloat values[3] = {value.x, value.y, value.z};
+    if (this->changed(uniform, values, sizeof(values)))
+        glUniform3f(this->uniforms->Entries[uniform.Index].Location, value.x, value.y, value.z);
 }
-void Shader::SetVector4f(const GLchar *name, const glm::vec4 &value, GLboolean useShader)
+void Shader::SetVector4f(UniformHandle uniform, const glm::vec4 &value, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    GLfloat values[4] = {value.x, value.y, value.z, value.w};
+    if (this->changed(uniform, values, sizeof(values)))
+        glUniform4f(this->uniforms->Entries[uniform.Index].Location, value.x, value.y, value.z, value.w);
 }
-void Shader::SetMatrix4(const GLchar *name, const glm::mat4 &matrix, GLboolean useShader)
+void Shader::SetMatrix4(UniformHandle uniform, const glm::mat4 &matrix, GLboolean useShader)
 {
     if (useShader)
         this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, GL_FALSE, glm::value_ptr(matrix));
+    if (this->changed(uniform, glm::value_ptr(matrix), 16 * sizeof(GLfloat)))
+        glUniformMatrix4fv(this->uniforms->Entries[uniform.Index].Location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
 void Shader::checkCompileErrors(GLuint object, std::string type)
@@ -1,12 +1,45 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// Binding point of the per frame uniform block. Every program declaring a
+// FrameData block is linked to it (see frame_data.hpp).
+const GLuint FRAME_DATA_BINDING = 0;
+
+// A uniform of one program, resolved once. Setting through a handle costs no
+// name lookup at all; an invalid handle (unknown or optimized out uniform)
+// makes the setters do nothing, like location -1 does in GL.
+struct UniformHandle
+{
+    GLint Index;
+
+    UniformHandle() : Index(-1) {}
+    explicit UniformHandle(GLint index) : Index(index) {}
+    bool Valid() const { return this->Index >= 0; }
+};
+
+// The program's active uniforms, read back after linking, with the last value
+// set on each so unchanged values never reach the driver
+struct ShaderUniforms
+{
+    struct Entry
+    {
+        std::string Name;
+        unsigned int Hash; // FNV-1a of Name
+        GLint Location;
+        bool Set;
+        GLfloat Value[16]; // Last value (ints are stored bit for bit)
+    };
+    std::vector<Entry> Entries;
+};
+
 class Shader
 {
 public:
@@ -14,7 +47,11 @@ public:
     Shader() {}
 
     Shader &Use();
-    void Compile(const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource = nullptr);
+    // fragmentSource may be null for transform feedback programs, which then
+    // capture the named vertex outputs (interleaved) instead of rasterizing
+    void Compile(const GLchar *vertexSource, const GLchar *fragmentSource, const GLchar *geometrySource = nullptr,
+                 const GLchar *const *feedbackVaryings = nullptr, GLsizei feedbackCount = 0);
+    UniformHandle GetUniform(const GLchar *name) const;
     void SetFloat(const GLchar *name, GLfloat value, GLboolean useShader = false);
     void SetInteger(const GLchar *name, GLint value, GLboolean useShader = false);
     void SetVector2f(const GLchar *name, GLfloat x, GLfloat y, GLboolean useShader = false);
@@ -24,7 +61,19 @@ public:
     void SetVector4f(const GLchar *name, GLfloat x, GLfloat y, GLfloat z, GLfloat w, GLboolean useShader = false);
     void SetVector4f(const GLchar *name, const glm::vec4 &value, GLboolean useShader = false);
     void SetMatrix4(const GLchar *name, const glm::mat4 &matrix, GLboolean useShader = false);
+    void SetFloat(UniformHandle uniform, GLfloat value, GLboolean useShader = false);
+    void SetInteger(UniformHandle uniform, GLint value, GLboolean useShader = false);
+    void SetVector2f(UniformHandle uniform, const glm::vec2 &value, GLboolean useShader = false);
+    void SetVector3f(UniformHandle uniform, const glm::vec3 &value, GLboolean useShader = false);
+    void SetVector4f(UniformHandle uniform, const glm::vec4 &value, GLboolean useShader = false);
+    void SetMatrix4(UniformHandle uniform, const glm::mat4 &matrix, GLboolean useShader = false);
 private:
+    // Shared by every copy of the shader (they are handed around by value)
+    std::shared_ptr<ShaderUniforms> uniforms;
+
+    void readUniforms();
+    // Whether value differs from the last one set on the uniform (and remember it)
+    bool changed(UniformHandle uniform, const void *value, size_t size);
     void checkCompileErrors(GLuint object, std::string type); 
 };
 
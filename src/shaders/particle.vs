@@ -1,15 +1,29 @@
 #version 330 core
 layout (location = 0) in vec2 vertex; // <vec2 position>
+// Per particle (instance) attributes
+layout (location = 1) in float offsetX;
+layout (location = 2) in float offsetY;
+layout (location = 3) in float brightness;
+layout (location = 4) in float alpha;
 
 out vec4 ParticleColor;
 
-uniform mat4 projection;
-uniform vec2 offset;
-uniform vec4 color;
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    vec2 viewport;
+    float time;
+    bool chaos;
+    bool confuse;
+    bool shake;
+};
 
 void main()
 {
     float scale = 10.0f;
-    ParticleColor = color;
-    gl_Position = projection * vec4((vertex.xy * scale) + offset, 1.0, 1.0);
+    ParticleColor = vec4(vec3(brightness), alpha);
+    gl_Position = projection * vec4((vertex.xy * scale) + vec2(offsetX, offsetY), 1.0, 1.0);
+    // Expired slots of the GPU backend: move them out of the clip volume
+    if (alpha <= 0.0)
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
 }
\ No newline at end of file
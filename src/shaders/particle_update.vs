@@ -0,0 +1,27 @@
+#version 330 core
+// Transform feedback pass: one point per particle slot, the outputs are
+// captured (in this order) into the other particle buffer
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 velocity;
+layout (location = 2) in float brightness;
+layout (location = 3) in float alpha;
+layout (location = 4) in float life;
+
+out vec2 outPosition;
+out vec2 outVelocity;
+out float outBrightness;
+out float outAlpha;
+out float outLife;
+
+uniform float deltaTime;
+uniform float fadeRate;
+
+void main()
+{
+    outPosition = position - velocity * deltaTime;
+    outVelocity = velocity;
+    outBrightness = brightness;
+    // Clamped so expired slots stay at zero (and get culled when drawn)
+    outAlpha = max(alpha - deltaTime * fadeRate, 0.0);
+    outLife = max(life - deltaTime, 0.0);
+}
\ No newline at end of file
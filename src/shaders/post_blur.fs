@@ -0,0 +1,15 @@
+#version 330 core
+in  vec2  TexCoords;
+out vec4  color;
+  
+uniform sampler2D scene;
+uniform vec2      direction; // Offset of the outer taps
+
+void main()
+{
+    // One direction of the 1 2 1 kernel
+    vec3 sum = texture(scene, TexCoords - direction).rgb * 0.25 +
+               texture(scene, TexCoords).rgb * 0.5 +
+               texture(scene, TexCoords + direction).rgb * 0.25;
+    color = vec4(sum, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#version 330 core
+in  vec2  TexCoords;
+out vec4  color;
+  
+uniform sampler2D scene;
+
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    vec2 viewport;
+    float time;
+    bool chaos;
+    bool confuse;
+    bool shake;
+};
+
+const float offset = 1.0 / 300.0;
+const vec2 offsets[9] = vec2[](
+    vec2(-offset, offset), vec2(0.0f, offset), vec2(offset, offset),
+    vec2(-offset, 0.0f), vec2(0.0f, 0.0f), vec2(offset, 0.0f),
+    vec2(-offset, -offset), vec2(0.0f, -offset), vec2(offset, -offset));
+const float edge_kernel[9] = float[](
+    -1, -1, -1,
+    -1, 8, -1,
+    -1, -1, -1);
+
+void main()
+{
+    // Edge detection of the scene swirling around (the scene texture repeats)
+    float strength = 0.3;
+    vec2 coords = TexCoords + vec2(sin(time), cos(time)) * strength;
+    color = vec4(0.0f);
+    for(int i = 0; i < 9; i++)
+        color += vec4(vec3(texture(scene, coords + offsets[i])) * edge_kernel[i], 0.0f);
+    color.a = 1.0f;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+in  vec2  TexCoords;
+out vec4  color;
+  
+uniform sampler2D scene;
+
+void main()
+{
+    // Upside down and inverted
+    color = vec4(1.0 - texture(scene, 1.0 - TexCoords).rgb, 1.0);
+}
\ No newline at end of file
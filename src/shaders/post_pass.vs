@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+
+out vec2 TexCoords;
+
+// Passes drawing to an intermediate target
+void main()
+{
+    gl_Position = vec4(vertex.xy, 0.0f, 1.0f); 
+    TexCoords = vertex.zw;
+}  
\ No newline at end of file
@@ -3,29 +3,21 @@ layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
 
 out vec2 TexCoords;
 
-uniform bool  chaos;
-uniform bool  confuse;
-uniform bool  shake;
-uniform float time;
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    vec2 viewport;
+    float time;
+    bool chaos;
+    bool confuse;
+    bool shake;
+};
 
+// Passes drawing to the screen: the quad moves with the shake
 void main()
 {
     gl_Position = vec4(vertex.xy, 0.0f, 1.0f); 
-    vec2 texture = vertex.zw;
-    if(chaos)
-    {
-        float strength = 0.3;
-        vec2 pos = vec2(texture.x + sin(time) * strength, texture.y + cos(time) * strength);        
-        TexCoords = pos;
-    }
-    else if(confuse)
-    {
-        TexCoords = vec2(1.0 - texture.x, 1.0 - texture.y);
-    }
-    else
-    {
-        TexCoords = texture;
-    }
+    TexCoords = vertex.zw;
     if (shake)
     {
         float strength = 0.01;
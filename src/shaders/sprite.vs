@@ -1,10 +1,32 @@
 #version 330 core
 layout (location = 0) in vec2 vertex;
+// Per sprite (instance) attributes
+layout (location = 1) in vec4 rect; // <vec2 position, vec2 size>
+layout (location = 2) in float rotation;
+layout (location = 3) in vec3 color;
+layout (location = 4) in vec4 uv; // <vec2 top left, vec2 bottom right>
 
-uniform mat4 model;
-uniform mat4 projection;
+out vec2 TexCoords;
+out vec3 SpriteColor;
+
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    vec2 viewport;
+    float time;
+    bool chaos;
+    bool confuse;
+    bool shake;
+};
 
 void main()
 {
-    gl_Position = projection * model * vec4(vertex, 0.0, 1.0);
+    // Scale the unit quad, rotate it around its center, then move it in place
+    vec2 local = (vertex - 0.5) * rect.zw;
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 world = rect.xy + 0.5 * rect.zw + vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+    TexCoords = mix(uv.xy, uv.zw, vertex);
+    SpriteColor = color;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
 }
\ No newline at end of file
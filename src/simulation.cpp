@@ -0,0 +1,235 @@
+#include "simulation.hpp"
+
+Simulation::Simulation(unsigned int width, unsigned int height)
+    : State(GAME_MENU),
+      Paddle1(Vec2(10.0f, height / 2 - PADDLE_SIZE.y / 2), PADDLE_SIZE),
+      Paddle2(Vec2(width - PADDLE_SIZE.x - 10.0f, height / 2 - PADDLE_SIZE.y / 2), PADDLE_SIZE),
+      Ball(Vec2(width / 2, height / 2), BALL_RADIUS, INITIAL_BALL_VELOCITY),
+      Paddle1Score(0), Paddle2Score(0), MaxScore(MAX_SCORE),
+      Width(width), Height(height)
+{
+}
+
+void Simulation::ProcessInput(unsigned int buttons, float deltaTime)
+{
+    if (this->State == GAME_ACTIVE)
+    {
+        Real deltaSpace = PADDLE_VELOCITY * Real(deltaTime);
+        // Move paddle one
+        if (buttons & INPUT_PADDLE1_UP)
+        {
+            if (this->Paddle1.Position.y >= 0)
+                this->Paddle1.Position.y -= deltaSpace;
+        }
+        if (buttons & INPUT_PADDLE1_DOWN)
+        {
+            if (this->Paddle1.Position.y <= this->Height - this->Paddle1.Size.y)
+                this->Paddle1.Position.y += deltaSpace;
+        }
+        // Move paddle two
+        if (buttons & INPUT_PADDLE2_UP)
+        {
+            if (this->Paddle2.Position.y >= 0)
+                this->Paddle2.Position.y -= deltaSpace;
+        }
+        if (buttons & INPUT_PADDLE2_DOWN)
+        {
+            if (this->Paddle2.Position.y <= this->Height - this->Paddle2.Size.y)
+                this->Paddle2.Position.y += deltaSpace;
+        }
+    }
+    if (this->State == GAME_MENU || this->State == GAME_WIN)
+    {
+        if (buttons & INPUT_START)
+        {
+            this->Reset();
+            this->State = GAME_ACTIVE;
+        }
+    }
+}
+
+unsigned int Simulation::Update(float deltaTime)
+{
+    unsigned int events = EVENT_NONE;
+    if (this->State == GAME_ACTIVE)
+    {
+        // Move the ball, resolving every collision along its path
+        events |= this->DoCollisions(deltaTime);
+        // Check loss condition
+        if (this->Ball.Position.x <= 0.0f)
+        {
+            this->Paddle2Score++;
+            events |= EVENT_PLAYER2_SCORED;
+            this->Serve();
+        }
+        else if (this->Ball.Position.x + this->Ball.Size.x >= this->Width)
+        {
+            this->Paddle1Score++;
+            events |= EVENT_PLAYER1_SCORED;
+            this->Serve();
+        }
+
+        if (this->Paddle1Score >= this->MaxScore || this->Paddle2Score >= this->MaxScore)
+        {
+            this->State = GAME_WIN;
+            events |= EVENT_MATCH_OVER;
+        }
+    }
+    return events;
+}
+
+void Simulation::Reset()
+{
+    this->Paddle1Score = 0;
+    this->Paddle2Score = 0;
+    this->Paddle1.Position = Vec2(10.0f, this->Height / 2 - PADDLE_SIZE.y / 2);
+    this->Paddle2.Position = Vec2(this->Width - PADDLE_SIZE.x - 10.0f, this->Height / 2 - PADDLE_SIZE.y / 2);
+    this->Serve();
+}
+
+void Simulation::Serve()
+{
+    this->Ball.Reset(Vec2(this->Width / 2, this->Height / 2), INITIAL_BALL_VELOCITY);
+}
+
+// Feeds bytes into an FNV-1a hash
+static void hashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+uint64_t Simulation::Hash() const
+{
+    uint64_t hash = 14695981039346656037ull;
+    const GameObject *objects[] = {&this->Paddle1, &this->Paddle2, &this->Ball};
+    for (int i = 0; i < 3; ++i)
+    {
+        hashBytes(hash, &objects[i]->Position, sizeof(objects[i]->Position));
+        hashBytes(hash, &objects[i]->Velocity, sizeof(objects[i]->Velocity));
+    }
+    int32_t values[] = {this->State, this->Paddle1Score, this->Paddle2Score};
+    hashBytes(hash, values, sizeof(values));
+    return hash;
+}
+
+// Swept collision: instead of testing for overlap after the ball moved, find the
+// earliest wall or paddle contact along its path, advance to it, bounce and
+// continue with the remaining time. This way a fast ball or a long step can't
+// tunnel through a paddle.
+unsigned int Simulation::DoCollisions(float deltaTime)
+{
+    unsigned int events = EVENT_NONE;
+    Real strength(2.0f);
+    Real remaining(deltaTime);
+    BallObject &ball = this->Ball;
+    for (int bounce = 0; bounce < MAX_BOUNCES_PER_STEP && remaining > 0.0f; ++bounce)
+    {
+        Real hitTime(-1.0f);
+        GameObject *hitPaddle = nullptr;
+        bool hitWall = false;
+        // Top and bottom walls
+        Real wallTime(-1.0f);
+        if (ball.Velocity.y < 0.0f)
+            wallTime = TimeOfImpact(ball.Position.y, ball.Velocity.y, 0.0f, remaining);
+        else if (ball.Velocity.y > 0.0f)
+            wallTime = TimeOfImpact(ball.Position.y, ball.Velocity.y, this->Height - ball.Size.y, remaining);
+        if (wallTime >= 0.0f)
+        {
+            hitTime = wallTime;
+            hitWall = true;
+        }
+        // Inner face of the paddle the ball is heading to
+        GameObject *paddle = nullptr;
+        Real paddleTime(-1.0f);
+        if (ball.Velocity.x < 0.0f)
+        {
+            paddle = &this->Paddle1;
+            Real face = paddle->Position.x + paddle->Size.x;
+            // Already overlapping the paddle counts as touching it right away
+            if (ball.Position.x < face && ball.Position.x + ball.Size.x >= paddle->Position.x)
+                paddleTime = 0.0f;
+            else
+                paddleTime = TimeOfImpact(ball.Position.x, ball.Velocity.x, face, remaining);
+        }
+        else if (ball.Velocity.x > 0.0f)
+        {
+            paddle = &this->Paddle2;
+            Real face = paddle->Position.x - ball.Size.x;
+            if (ball.Position.x > face && ball.Position.x <= paddle->Position.x + paddle->Size.x)
+                paddleTime = 0.0f;
+            else
+                paddleTime = TimeOfImpact(ball.Position.x, ball.Velocity.x, face, remaining);
+        }
+        if (paddleTime >= 0.0f && (hitTime < 0.0f || paddleTime <= hitTime))
+        {
+            // Only a hit if the ball overlaps the paddle vertically at that time
+            Real ballY = ball.Position.y + ball.Velocity.y * paddleTime;
+            if (ballY + ball.Size.y >= paddle->Position.y && paddle->Position.y + paddle->Size.y >= ballY)
+            {
+                hitTime = paddleTime;
+                hitPaddle = paddle;
+                hitWall = false;
+            }
+        }
+        if (hitTime < 0.0f)
+        {
+            // Free flight for the rest of the step
+            ball.Position += ball.Velocity * remaining;
+            remaining = Real(0.0f);
+            break;
+        }
+
+        ball.Position += ball.Velocity * hitTime;
+        remaining -= hitTime;
+        if (hitPaddle != nullptr)
+        {
+            events |= EVENT_PADDLE_HIT;
+
+            Vec2 oldVelocity = ball.Velocity;
+            Real centerBoard = hitPaddle->Position.y + hitPaddle->Size.y / 2;
+            Real distance = (ball.Position.y + ball.Radius) - centerBoard;
+            Real percentage = distance / (hitPaddle->Size.y / 2);
+
+            ball.Velocity.y = INITIAL_BALL_VELOCITY.y * percentage * strength;
+            ball.Velocity = Normalize(ball.Velocity) * Length(oldVelocity);
+            ball.Velocity.x = -ball.Velocity.x;
+            if (hitPaddle == &this->Paddle1)
+                ball.Position.x = hitPaddle->Position.x + hitPaddle->Size.x;
+            else
+                ball.Position.x = hitPaddle->Position.x - ball.Size.x;
+        }
+        else if (hitWall)
+        {
+            ball.Velocity.y = -ball.Velocity.y;
+            ball.Position.y = ball.Velocity.y > 0.0f ? Real(0.0f) : this->Height - ball.Size.y;
+        }
+    }
+    if (remaining > 0.0f)
+    {
+        // Out of bounces, e.g. wedged between a paddle and a wall: fly the rest
+        // of the step without looking for contacts, kept inside the walls,
+        // instead of stalling for it
+        ball.Position += ball.Velocity * remaining;
+        if (ball.Position.y < 0.0f)
+            ball.Position.y = Real(0.0f);
+        else if (ball.Position.y > this->Height - ball.Size.y)
+            ball.Position.y = this->Height - ball.Size.y;
+    }
+    return events;
+}
+
+Real TimeOfImpact(Real position, Real velocity, Real target, Real maxTime)
+{
+    if (velocity == 0.0f)
+        return -1.0f;
+    Real time = (target - position) / velocity;
+    // Moving away from the target or not reaching it within this step
+    if (time < 0.0f || time > maxTime)
+        return -1.0f;
+    return time;
+}
\ No newline at end of file
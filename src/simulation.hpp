@@ -0,0 +1,76 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "numeric.hpp"
+#include "game_object.hpp"
+#include "ball_object.hpp"
+
+enum GameState
+{
+    GAME_ACTIVE,
+    GAME_MENU,
+    GAME_WIN
+};
+
+// Buttons held during a simulation step, packed as bits so any input source
+// (keyboard, replay, bot) can drive the rules the same way
+enum InputButton
+{
+    INPUT_PADDLE1_UP   = 1 << 0,
+    INPUT_PADDLE1_DOWN = 1 << 1,
+    INPUT_PADDLE2_UP   = 1 << 2,
+    INPUT_PADDLE2_DOWN = 1 << 3,
+    INPUT_START        = 1 << 4
+};
+
+// What happened during a step, so the presentation layer can play sounds/effects
+enum SimulationEvent
+{
+    EVENT_NONE           = 0,
+    EVENT_PADDLE_HIT     = 1 << 0,
+    EVENT_PLAYER1_SCORED = 1 << 1,
+    EVENT_PLAYER2_SCORED = 1 << 2,
+    EVENT_MATCH_OVER     = 1 << 3
+};
+
+const Vec2 PADDLE_SIZE(20, 100);
+const Real PADDLE_VELOCITY(500.0f);
+const Vec2 INITIAL_BALL_VELOCITY(450.0f, 300.0f);
+const Real BALL_RADIUS(10.0f);
+const int MAX_SCORE = 10;
+// Upper bound of wall/paddle bounces resolved within a single step
+const int MAX_BOUNCES_PER_STEP = 8;
+
+// The game rules without any rendering, audio or windowing dependency
+class Simulation
+{
+  public:
+    GameState State;
+    GameObject Paddle1, Paddle2;
+    BallObject Ball;
+    int Paddle1Score, Paddle2Score, MaxScore;
+    unsigned int Width, Height;
+
+    Simulation(unsigned int width, unsigned int height);
+
+    void ProcessInput(unsigned int buttons, float deltaTime);
+    unsigned int Update(float deltaTime);
+    unsigned int DoCollisions(float deltaTime);
+
+    void Reset();
+    void Serve();
+    // FNV-1a over the paddle and ball positions and velocities, the game
+    // state and the scores, to compare simulations cheaply.
+    // Only comparable between builds using the same numeric mode.
+    uint64_t Hash() const;
+};
+
+// Time (in [0, maxTime]) at which a box moving with velocity along one axis
+// reaches the given coordinate, or a negative value if it doesn't
+Real TimeOfImpact(Real position, Real velocity, Real target, Real maxTime);
+
+#endif
\ No newline at end of file
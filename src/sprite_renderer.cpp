@@ -2,7 +2,12 @@
 
 #include <iostream>
 
+// Floats per sprite in the instance stream: x, y, width, height, rotation,
+// r, g, b, then the texture rect u0, v0, u1, v1
+const GLuint SPRITE_FLOATS = 12;
+
 SpriteRenderer::SpriteRenderer(Shader shader)
+    : batching(false)
 {
     this->shader = shader;
     this->initRenderData();
@@ -10,34 +15,84 @@ SpriteRenderer::SpriteRenderer(Shader shader)
 
 SpriteRenderer::~SpriteRenderer()
 {
-    glDeleteVertexArrays(1, &this->quadVAO);
+    for (std::map<GLuint, Batch>::value_type &entry : this->batches)
+    {
+        glDeleteVertexArrays(1, &entry.second.VAO);
+        glDeleteBuffers(1, &entry.second.VBO);
+    }
+    glDeleteBuffers(1, &this->quadVBO);
+    glDeleteTextures(1, &this->white.ID);
 }
 
-void SpriteRenderer::DrawSprite(glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
+void SpriteRenderer::Begin()
 {
-    // Prepare transformations
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));
+    for (std::map<GLuint, Batch>::value_type &entry : this->batches)
+        entry.second.Instances.clear();
+    this->batching = true;
+}
 
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f));
-    model = glm::rotate(model, rotate, glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f));
+void SpriteRenderer::Submit(glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
+{
+    AtlasRegion region;
+    region.Texture = this->white.ID;
+    this->Submit(region, position, size, rotate, color);
+}
 
-    model = glm::scale(model, glm::vec3(size, 1.0f));
+void SpriteRenderer::Submit(const AtlasRegion &region, glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
+{
+    GLfloat sprite[SPRITE_FLOATS] = {position.x, position.y, size.x, size.y, rotate, color.r, color.g, color.b,
+                                     region.UV.x, region.UV.y, region.UV.z, region.UV.w};
+    std::vector<GLfloat> &instances = this->batch(region.Texture).Instances;
+    instances.insert(instances.end(), sprite, sprite + SPRITE_FLOATS);
+}
 
-    this->shader.Use();
-    this->shader.SetMatrix4("model", model);
-    this->shader.SetVector3f("spriteColor", color);
+void SpriteRenderer::Submit(const GameObject &object)
+{
+    this->Submit(ToGlm(object.Position), ToGlm(object.Size), object.Rotation, object.Color);
+}
 
-    glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+void SpriteRenderer::Flush()
+{
+    RenderQueue queue;
+    this->Flush(queue);
+    queue.Execute();
+}
+
+void SpriteRenderer::Flush(RenderQueue &queue)
+{
+    this->batching = false;
+    for (std::map<GLuint, Batch>::value_type &entry : this->batches)
+    {
+        Batch &batch = entry.second;
+        GLsizei count = static_cast<GLsizei>(batch.Instances.size() / SPRITE_FLOATS);
+        if (count == 0)
+            continue;
+        glBindBuffer(GL_ARRAY_BUFFER, batch.VBO);
+        glBufferData(GL_ARRAY_BUFFER, batch.Instances.size() * sizeof(GLfloat), batch.Instances.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        batch.Instances.clear();
+
+        queue.Submit(RENDER_LAYER_SPRITES, this->shader.ID, entry.first, batch.VAO, BLEND_ALPHA, [count]() {
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+        });
+    }
+}
+
+void SpriteRenderer::DrawSprite(glm::vec2 position, glm::vec2 size, GLfloat rotate, glm::vec3 color)
+{
+    this->Submit(position, size, rotate, color);
+    if (!this->batching)
+        this->Flush();
+}
+
+void SpriteRenderer::DrawSprite(const GameObject &object)
+{
+    this->DrawSprite(ToGlm(object.Position), ToGlm(object.Size), object.Rotation, object.Color);
 }
 
 void SpriteRenderer::initRenderData()
 {
-    // Configure VAO/VBO
-    GLuint VBO;
+    // Configure VBO, the VAOs are made per batch
     GLfloat vertices[] = {
         // Pos
         0.0f, 1.0f,
@@ -48,15 +103,43 @@ void SpriteRenderer::initRenderData()
         1.0f, 1.0f,
         1.0f, 0.0f};
 
-    glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glGenBuffers(1, &this->quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    unsigned char texel[4] = {255, 255, 255, 255};
+    this->white.Internal_Format = GL_RGBA;
+    this->white.Image_Format = GL_RGBA;
+    this->white.Generate(1, 1, texel);
+}
 
-    glBindVertexArray(this->quadVAO);
+SpriteRenderer::Batch &SpriteRenderer::batch(GLuint texture)
+{
+    std::map<GLuint, Batch>::iterator found = this->batches.find(texture);
+    if (found != this->batches.end())
+        return found->second;
+    Batch &batch = this->batches[texture];
+    glGenVertexArrays(1, &batch.VAO);
+    glBindVertexArray(batch.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid *)0);
+
+    // Per sprite attributes: rect (position, size), rotation, color, texture rect
+    GLsizei stride = SPRITE_FLOATS * sizeof(GLfloat);
+    glGenBuffers(1, &batch.VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.VBO);
+    GLint sizes[] = {4, 1, 3, 4};
+    GLuint offset = 0;
+    for (GLuint i = 0; i < 4; ++i)
+    {
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, sizes[i], GL_FLOAT, GL_FALSE, stride, (GLvoid *)(offset * sizeof(GLfloat)));
+        glVertexAttribDivisor(1 + i, 1);
+        offset += sizes[i];
+    }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-}
\ No newline at end of file
+    return batch;
+}
@@ -1,25 +1,57 @@
 #ifndef SPRITE_RENDERER_H
 #define SPRITE_RENDERER_H
 
+#include <map>
+#include <vector>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
 
 #include "texture.hpp"
+#include "texture_atlas.hpp"
 #include "shader.hpp"
+#include "render_queue.hpp"
+#include "game_object.hpp"
 
+// Sprites are batched: between Begin() and Flush() every sprite is appended
+// to an instance stream (rect, rotation, color, texture rect), and Flush()
+// draws each stream with a single instanced call. sprite.vs does the rotation
+// and scaling, so no per sprite matrices are built on the CPU. Outside of a
+// batch DrawSprite draws right away.
+// There is one stream per texture: sprites cut from the same atlas page share
+// a draw, and untextured sprites use a white texel of their own. Flush(queue)
+// uploads the streams and hands the draws to a render queue instead; only one
+// batch per queue execution, the next one reuses the buffers.
 class SpriteRenderer
 {
 public:
     SpriteRenderer(Shader shader);
     ~SpriteRenderer();
-    
+
+    void Begin();
+    void Submit(glm::vec2 position, glm::vec2 size = glm::vec2(10, 10), GLfloat rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    void Submit(const AtlasRegion &region, glm::vec2 position, glm::vec2 size, GLfloat rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    void Submit(const GameObject &object);
+    void Flush();
+    void Flush(RenderQueue &queue);
+
     void DrawSprite(glm::vec2 position, glm::vec2 size = glm::vec2(10, 10), GLfloat rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    void DrawSprite(const GameObject &object);
 private:
+    struct Batch
+    {
+        GLuint VAO, VBO; // Quad plus this batch's instance stream
+        std::vector<GLfloat> Instances;
+    };
+
     Shader shader; 
-    GLuint quadVAO;
+    GLuint quadVBO;
+    Texture2D white; // 1x1, for untextured sprites
+    std::map<GLuint, Batch> batches; // By texture
+    bool batching;
 
     void initRenderData();
+    Batch &batch(GLuint texture);
 };
 
 #endif
\ No newline at end of file
@@ -1,129 +1,671 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 
-#include <glm/gtc/matrix_transform.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 #include "text_renderer.hpp"
 #include "resource_manager.hpp"
+#include "distance_field.hpp"
 
-TextRenderer::TextRenderer(GLuint width, GLuint height)
+// Floats per glyph vertex: position, texture coordinates, color
+const GLuint TEXT_VERTEX_FLOATS = 7;
+
+TextRenderer::TextRenderer()
+    : top(0.0f), uploaded(false), fontSize(0), library(nullptr), face(nullptr), cellSize(0), latinGlyphs(), frame(1), worker(1)
 {
     // Load and configure shader
     this->TextShader = ResourceManager::LoadShader("../src/shaders/text.vs", "../src/shaders/text.fs", nullptr, "text");
-    this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<GLfloat>(width), static_cast<GLfloat>(height), 0.0f), GL_TRUE);
-    this->TextShader.SetInteger("text", 0);
+    this->TextShader.SetInteger("text", 0, GL_TRUE);
     // Configure VAO/VBO for texture quads
-    glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
-    glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    this->VAO = this->makeVertexArray(this->VBO);
+}
+
+TextRenderer::~TextRenderer()
+{
+    // The worker may still be rasterizing with the face
+    this->worker.Wait();
+    this->closeFace();
+    for (TextMesh &mesh : this->meshes)
+    {
+        glDeleteVertexArrays(1, &mesh.VAO);
+        glDeleteBuffers(1, &mesh.VBO);
+    }
+    glDeleteVertexArrays(1, &this->VAO);
+    glDeleteBuffers(1, &this->VBO);
+    for (Texture2D &page : this->Pages)
+        glDeleteTextures(1, &page.ID);
+}
+
+GLuint TextRenderer::makeVertexArray(GLuint vbo) const
+{
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, TEXT_VERTEX_FLOATS * sizeof(GLfloat), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, TEXT_VERTEX_FLOATS * sizeof(GLfloat), (GLvoid *)(4 * sizeof(GLfloat)));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    return vao;
+}
+
+// Decodes the UTF-8 sequence text points at and moves past it. Malformed
+// sequences decode to U+FFFD, without swallowing the bytes after them.
+static uint32_t decodeUtf8(const char *&text)
+{
+    const unsigned char *c = reinterpret_cast<const unsigned char *>(text);
+    uint32_t codepoint;
+    int length;
+    if (c[0] < 0x80)
+    {
+        codepoint = c[0];
+        length = 1;
+    }
+    else if ((c[0] & 0xE0) == 0xC0)
+    {
+        codepoint = c[0] & 0x1F;
+        length = 2;
+    }
+    else if ((c[0] & 0xF0) == 0xE0)
+    {
+        codepoint = c[0] & 0x0F;
+        length = 3;
+    }
+    else if ((c[0] & 0xF8) == 0xF0)
+    {
+        codepoint = c[0] & 0x07;
+        length = 4;
+    }
+    else
+    {
+        text++;
+        return 0xFFFD;
+    }
+    for (int i = 1; i < length; ++i)
+    {
+        // Also stops at the terminator of a truncated sequence
+        if ((c[i] & 0xC0) != 0x80)
+        {
+            text += i;
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (c[i] & 0x3F);
+    }
+    text += length;
+    // Overlong encodings, surrogates and values past Unicode
+    static const uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (codepoint < minimum[length] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+        return 0xFFFD;
+    return codepoint;
+}
+
+// Glyph cache file: header, then every glyph followed by its field
+const char FONT_CACHE_MAGIC[8] = {'P', 'O', 'N', 'G', 'S', 'D', 'F', '3'};
+// Bump when the layout or the SDF parameters change
+const uint32_t FONT_CACHE_VERSION = 3;
+// The cached glyphs: printable ASCII
+const uint32_t FONT_CACHE_FIRST = 32, FONT_CACHE_LAST = 126;
+
+struct FontCacheHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t FontSize;
+    uint64_t FontHash; // FNV-1a of the font file
+    uint32_t CellSize;
+    uint32_t Count;
+    float Top;
+};
+
+struct FontCacheGlyph
+{
+    uint32_t Codepoint;
+    uint32_t Size[2]; // Of the field, in pixels
+    float Bearing[2];
+    uint32_t Advance;
+};
+
+static uint64_t hashFont(const std::string &data)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char byte : data)
+        hash = (hash ^ byte) * 1099511628211ull;
+    return hash;
 }
 
 void TextRenderer::Load(std::string font, GLuint fontSize)
 {
-    // First clear the previously loaded Characters
-    this->Characters.clear();
-    // Then initialize and load the FreeType library
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) // All functions return a value different than 0 whenever an error occurred
+    // First let the worker finish with the previous font and drop its glyphs
+    this->worker.Wait();
+    for (Texture2D &page : this->Pages)
+        glDeleteTextures(1, &page.ID);
+    this->Pages.clear();
+    this->glyphs.clear();
+    std::fill(this->latinGlyphs, this->latinGlyphs + 256, nullptr);
+    this->slots.clear();
+    this->stored.clear();
+    this->requested.clear();
+    this->ready.clear();
+    this->closeFace();
+    // Retained meshes were built from the old glyphs
+    for (TextMesh &mesh : this->meshes)
+        mesh.Built = false;
+
+    // The cache next to the font is only used if it was made from the same
+    // file at the same size; otherwise the glyphs are generated and cached
+    std::ifstream fontFile(font.c_str(), std::ios::binary);
+    this->fontData.assign((std::istreambuf_iterator<char>(fontFile)), std::istreambuf_iterator<char>());
+    if (this->fontData.empty())
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+    this->fontSize = fontSize;
+    uint64_t fontHash = hashFont(this->fontData);
+    std::stringstream cacheFile;
+    cacheFile << font << "." << fontSize << ".sdf";
+    if (this->loadCache(cacheFile.str(), fontHash))
+        return;
+
+    // Cells fit a line of text (wider glyphs get cropped) and the spread
+    this->cellSize = std::min(fontSize + 2 * SDF_SPREAD + 1, TEXT_PAGE_SIZE);
+    {
+        std::lock_guard<std::mutex> guard(this->faceLock);
+        this->openFace();
+        if (this->face != nullptr)
+        {
+            GLuint height = static_cast<GLuint>((this->face->size->metrics.height + 63) / 64 + SDF_UPSCALE - 1) / SDF_UPSCALE;
+            this->cellSize = std::min(std::max(height, fontSize) + 2 * SDF_SPREAD + 1, TEXT_PAGE_SIZE);
+            if (FT_Load_Char(this->face, 'H', FT_LOAD_RENDER) == 0)
+                this->top = this->face->glyph->bitmap_top / static_cast<GLfloat>(SDF_UPSCALE);
+        }
+    }
+    // The worker generates the cached glyphs, meanwhile text rasterizes what
+    // it needs right away
+    for (uint32_t c = FONT_CACHE_FIRST; c <= FONT_CACHE_LAST; ++c)
+        this->requested.insert(c);
+    std::string file = cacheFile.str();
+    this->worker.Submit([this, file, fontHash]() {
+        std::vector<GlyphBitmap> bitmaps(FONT_CACHE_LAST - FONT_CACHE_FIRST + 1);
+        for (uint32_t c = FONT_CACHE_FIRST; c <= FONT_CACHE_LAST; ++c)
+            this->rasterize(c, bitmaps[c - FONT_CACHE_FIRST]);
+        this->saveCache(file, fontHash, bitmaps);
+        std::lock_guard<std::mutex> guard(this->readyLock);
+        for (GlyphBitmap &bitmap : bitmaps)
+            this->ready.push_back(std::move(bitmap));
+    });
+}
+
+void TextRenderer::Preload(const std::string &text)
+{
+    std::vector<uint32_t> codepoints;
+    for (const char *c = text.c_str(); *c != '\0';)
+    {
+        uint32_t codepoint = decodeUtf8(c);
+        if (this->glyphs.count(codepoint) == 0 && this->stored.count(codepoint) == 0 && this->requested.insert(codepoint).second)
+            codepoints.push_back(codepoint);
+    }
+    if (codepoints.empty())
+        return;
+    this->worker.Submit([this, codepoints]() {
+        std::vector<GlyphBitmap> bitmaps(codepoints.size());
+        for (size_t i = 0; i < codepoints.size(); ++i)
+            this->rasterize(codepoints[i], bitmaps[i]);
+        std::lock_guard<std::mutex> guard(this->readyLock);
+        for (GlyphBitmap &bitmap : bitmaps)
+            this->ready.push_back(std::move(bitmap));
+    });
+}
+
+void TextRenderer::BeginFrame()
+{
+    this->frame++;
+    this->collect();
+}
+
+void TextRenderer::collect()
+{
+    std::vector<GlyphBitmap> arrived;
+    {
+        std::lock_guard<std::mutex> guard(this->readyLock);
+        if (this->ready.empty())
+            return;
+        arrived.swap(this->ready);
+    }
+    for (GlyphBitmap &bitmap : arrived)
+    {
+        this->requested.erase(bitmap.Codepoint);
+        this->stats.Preloaded++;
+        // The cached glyphs are kept at hand, the others go to the atlas
+        // (unless they were needed before they were ready)
+        if (bitmap.Codepoint >= FONT_CACHE_FIRST && bitmap.Codepoint <= FONT_CACHE_LAST)
+            this->stored[bitmap.Codepoint] = std::move(bitmap);
+        else if (this->glyphs.count(bitmap.Codepoint) == 0)
+            this->place(bitmap);
+    }
+}
+
+// Called with faceLock held
+void TextRenderer::openFace()
+{
+    if (this->face != nullptr)
+        return;
+    // Initialize and load the FreeType library
+    FT_Library library;
+    if (FT_Init_FreeType(&library)) // All functions return a value different than 0 whenever an error occurred
+    {
         std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return;
+    }
     // Load font as face
     FT_Face face;
-    if (FT_New_Face(ft, font.c_str(), 0, &face))
+    if (FT_New_Memory_Face(library, reinterpret_cast<const FT_Byte *>(this->fontData.data()), static_cast<FT_Long>(this->fontData.size()), 0, &face))
+    {
         std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-    // Set size to load glyphs as
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-    // Disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    // Then for the first 128 ASCII characters, pre-load/compile their characters and store them
-    for (GLubyte c = 0; c < 128; c++) // lol see what I did there
+        FT_Done_FreeType(library);
+        return;
+    }
+    // Glyphs are rendered larger than their atlas size, their distance
+    // fields are then scaled down
+    FT_Set_Pixel_Sizes(face, 0, this->fontSize * SDF_UPSCALE);
+    this->library = library;
+    this->face = face;
+}
+
+void TextRenderer::closeFace()
+{
+    std::lock_guard<std::mutex> guard(this->faceLock);
+    if (this->face != nullptr)
+        FT_Done_Face(this->face);
+    if (this->library != nullptr)
+        FT_Done_FreeType(this->library);
+    this->face = nullptr;
+    this->library = nullptr;
+}
+
+// Thread safe: only the FreeType part holds the face
+bool TextRenderer::rasterize(uint32_t codepoint, GlyphBitmap &glyph)
+{
+    glyph.Codepoint = codepoint;
+    glyph.Size = glm::vec2(0.0f);
+    glyph.Bearing = glm::vec2(0.0f);
+    glyph.Advance = 0;
+    glyph.Field.clear();
+    std::vector<unsigned char> bitmap;
+    int width, rows;
     {
+        std::lock_guard<std::mutex> guard(this->faceLock);
+        this->openFace();
         // Load character glyph
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
+        if (this->face == nullptr || FT_Load_Char(this->face, codepoint, FT_LOAD_RENDER))
         {
             std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
+            return false;
         }
-        // Generate texture
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer);
-        // Set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            GLuint(face->glyph->advance.x)};
-        Characters.insert(std::pair<GLchar, Character>(c, character));
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // Destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-}
-
-void TextRenderer::RenderText(std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
-{
-    // Activate corresponding render state
-    this->TextShader.Use();
-    this->TextShader.SetVector3f("textColor", color);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(this->VAO);
-
-    // Iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
-    {
-        Character ch = Characters[*c];
-
-        GLfloat xpos = x + ch.Bearing.x * scale;
-        GLfloat ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
-
-        GLfloat w = ch.Size.x * scale;
-        GLfloat h = ch.Size.y * scale;
-        // Update VBO for each character
-        GLfloat vertices[6][4] = {
-            {xpos, ypos + h, 0.0, 1.0},
-            {xpos + w, ypos, 1.0, 0.0},
-            {xpos, ypos, 0.0, 0.0},
-
-            {xpos, ypos + h, 0.0, 1.0},
-            {xpos + w, ypos + h, 1.0, 1.0},
-            {xpos + w, ypos, 1.0, 0.0}};
-        // Render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // Update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // Render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // Now advance cursors for next glyph
-        x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+        FT_GlyphSlot slot = this->face->glyph;
+        glyph.Advance = GLuint(slot->advance.x / SDF_UPSCALE);
+        width = slot->bitmap.width;
+        rows = slot->bitmap.rows;
+        if (width == 0 || rows == 0)
+            return true; // Blank, only advances
+        // The field extends SDF_SPREAD pixels past the glyph on every side
+        GLfloat upscale = static_cast<GLfloat>(SDF_UPSCALE);
+        glyph.Bearing = glm::vec2(slot->bitmap_left / upscale - SDF_SPREAD, slot->bitmap_top / upscale + SDF_SPREAD);
+        // Copied out, so the field is computed without holding the face
+        bitmap.resize(width * rows);
+        for (int row = 0; row < rows; ++row)
+            std::memcpy(&bitmap[row * width], slot->bitmap.buffer + row * slot->bitmap.pitch, width);
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+    int fieldWidth, fieldHeight;
+    DistanceField(bitmap.data(), width, rows, width, SDF_UPSCALE, SDF_SPREAD, glyph.Field, fieldWidth, fieldHeight);
+    glyph.Size = glm::vec2(fieldWidth, fieldHeight);
+    return true;
+}
+
+const TextRenderer::Glyph *TextRenderer::lookup(uint32_t codepoint)
+{
+    // Nearly all text is ASCII: those glyphs come straight from a flat table,
+    // only the rest of Unicode goes through the map
+    Glyph *found = nullptr;
+    if (codepoint < 256)
+        found = this->latinGlyphs[codepoint];
+    else
+    {
+        std::unordered_map<uint32_t, Glyph>::iterator entry = this->glyphs.find(codepoint);
+        if (entry != this->glyphs.end())
+            found = &entry->second;
+    }
+    if (found != nullptr)
+    {
+        if (found->Slot >= 0)
+            this->slots[found->Slot].LastUsed = this->frame;
+        return found;
+    }
+    std::unordered_map<uint32_t, GlyphBitmap>::iterator cached = this->stored.find(codepoint);
+    if (cached != this->stored.end())
+        return this->place(cached->second);
+    // Not loaded yet (nor ready from the worker): rasterize it now. Glyphs
+    // that fail to load stay blank rather than being retried every frame.
+    GlyphBitmap bitmap;
+    this->rasterize(codepoint, bitmap);
+    this->stats.Rasterized++;
+    return this->place(bitmap);
+}
+
+const TextRenderer::Glyph *TextRenderer::place(const GlyphBitmap &bitmap)
+{
+    Glyph glyph;
+    glyph.Metrics.Size = glm::vec2(0.0f);
+    glyph.Metrics.Bearing = bitmap.Bearing;
+    glyph.Metrics.Advance = bitmap.Advance;
+    glyph.Metrics.UV = glm::vec4(0.0f);
+    glyph.Metrics.Texture = 0;
+    glyph.Slot = -1;
+    if (!bitmap.Field.empty())
+    {
+        int slot = this->allocateSlot();
+        if (slot < 0)
+            return nullptr; // Every cell holds a glyph of this frame
+        GLuint perRow = TEXT_PAGE_SIZE / this->cellSize;
+        GLuint page = slot / (perRow * perRow), index = slot % (perRow * perRow);
+        GLuint x = (index % perRow) * this->cellSize, y = (index / perRow) * this->cellSize;
+        GLuint fieldWidth = static_cast<GLuint>(bitmap.Size.x);
+        GLuint width = std::min(fieldWidth, this->cellSize), height = std::min(static_cast<GLuint>(bitmap.Size.y), this->cellSize);
+        // The whole cell is written, which also clears what the glyph that
+        // had it before left around this one
+        this->cell.assign(this->cellSize * this->cellSize, 0);
+        for (GLuint row = 0; row < height; ++row)
+            std::memcpy(&this->cell[row * this->cellSize], &bitmap.Field[row * fieldWidth], width);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, this->Pages[page].ID);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, this->cellSize, this->cellSize, GL_RED, GL_UNSIGNED_BYTE, this->cell.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        GLfloat size = static_cast<GLfloat>(TEXT_PAGE_SIZE);
+        glyph.Metrics.Size = glm::vec2(width, height);
+        glyph.Metrics.UV = glm::vec4(x / size, y / size, (x + width) / size, (y + height) / size);
+        glyph.Metrics.Texture = this->Pages[page].ID;
+        glyph.Slot = slot;
+        this->slots[slot].Codepoint = bitmap.Codepoint;
+        this->slots[slot].LastUsed = this->frame;
+    }
+    // Map entries never move, so the flat table can point into it
+    Glyph &placed = this->glyphs[bitmap.Codepoint];
+    placed = glyph;
+    if (bitmap.Codepoint < 256)
+        this->latinGlyphs[bitmap.Codepoint] = &placed;
+    return &placed;
+}
+
+int TextRenderer::allocateSlot()
+{
+    GLuint perRow = TEXT_PAGE_SIZE / this->cellSize;
+    GLuint perPage = perRow * perRow;
+    if (this->slots.size() < perPage * TEXT_MAX_PAGES)
+    {
+        if (this->slots.size() == this->Pages.size() * perPage)
+        {
+            // Every page is full, start a new one
+            std::vector<unsigned char> empty(TEXT_PAGE_SIZE * TEXT_PAGE_SIZE, 0);
+            Texture2D page;
+            page.Internal_Format = GL_RED;
+            page.Image_Format = GL_RED;
+            page.Wrap_S = GL_CLAMP_TO_EDGE;
+            page.Wrap_T = GL_CLAMP_TO_EDGE;
+            page.Generate(TEXT_PAGE_SIZE, TEXT_PAGE_SIZE, empty.data());
+            this->Pages.push_back(page);
+        }
+        Slot slot = {0, 0, 0};
+        this->slots.push_back(slot);
+        return static_cast<int>(this->slots.size() - 1);
+    }
+    // Every cell is taken: the least recently drawn glyph goes, as long as it
+    // wasn't drawn this frame (queued draws still point at it). A linear scan
+    // is plenty, this only happens when a new glyph was rasterized anyway.
+    int oldest = -1;
+    for (size_t i = 0; i < this->slots.size(); ++i)
+        if (this->slots[i].LastUsed < this->frame && (oldest < 0 || this->slots[i].LastUsed < this->slots[oldest].LastUsed))
+            oldest = static_cast<int>(i);
+    if (oldest >= 0)
+    {
+        uint32_t codepoint = this->slots[oldest].Codepoint;
+        this->glyphs.erase(codepoint);
+        if (codepoint < 256)
+            this->latinGlyphs[codepoint] = nullptr;
+        this->slots[oldest].Generation++;
+        this->stats.Evicted++;
+    }
+    return oldest;
+}
+
+bool TextRenderer::loadCache(const std::string &file, uint64_t fontHash)
+{
+    std::ifstream stream(file.c_str(), std::ios::binary);
+    FontCacheHeader header;
+    if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return false;
+    if (std::memcmp(header.Magic, FONT_CACHE_MAGIC, sizeof(FONT_CACHE_MAGIC)) != 0 || header.Version != FONT_CACHE_VERSION ||
+        header.FontHash != fontHash || header.FontSize != this->fontSize || header.CellSize == 0 || header.CellSize > TEXT_PAGE_SIZE ||
+        header.Count > FONT_CACHE_LAST - FONT_CACHE_FIRST + 1)
+        return false;
+    std::unordered_map<uint32_t, GlyphBitmap> glyphs;
+    for (uint32_t i = 0; i < header.Count; ++i)
+    {
+        FontCacheGlyph record;
+        if (!stream.read(reinterpret_cast<char *>(&record), sizeof(record)) || record.Size[0] > TEXT_PAGE_SIZE || record.Size[1] > TEXT_PAGE_SIZE ||
+            !std::isfinite(record.Bearing[0]) || !std::isfinite(record.Bearing[1]))
+            return false;
+        GlyphBitmap &glyph = glyphs[record.Codepoint];
+        glyph.Codepoint = record.Codepoint;
+        glyph.Size = glm::vec2(record.Size[0], record.Size[1]);
+        glyph.Bearing = glm::vec2(record.Bearing[0], record.Bearing[1]);
+        glyph.Advance = record.Advance;
+        glyph.Field.resize(static_cast<size_t>(record.Size[0]) * record.Size[1]);
+        if (!stream.read(reinterpret_cast<char *>(glyph.Field.data()), glyph.Field.size()))
+            return false;
+    }
+    this->stored.swap(glyphs);
+    this->cellSize = header.CellSize;
+    this->top = header.Top;
+    return true;
+}
+
+void TextRenderer::saveCache(const std::string &file, uint64_t fontHash, const std::vector<GlyphBitmap> &bitmaps) const
+{
+    std::ofstream stream(file.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "ERROR::FREETYPE: Failed to write the glyph cache " << file << std::endl;
+        return;
+    }
+    FontCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, FONT_CACHE_MAGIC, sizeof(FONT_CACHE_MAGIC));
+    header.Version = FONT_CACHE_VERSION;
+    header.FontSize = this->fontSize;
+    header.FontHash = fontHash;
+    header.CellSize = this->cellSize;
+    header.Count = static_cast<uint32_t>(bitmaps.size());
+    header.Top = this->top;
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const GlyphBitmap &glyph : bitmaps)
+    {
+        FontCacheGlyph record = {glyph.Codepoint, {static_cast<uint32_t>(glyph.Size.x), static_cast<uint32_t>(glyph.Size.y)},
+                                 {glyph.Bearing.x, glyph.Bearing.y}, glyph.Advance};
+        stream.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        stream.write(reinterpret_cast<const char *>(glyph.Field.data()), glyph.Field.size());
+    }
+}
+
+void TextRenderer::RenderText(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+{
+    RenderQueue queue;
+    this->RenderText(queue, text, x, y, scale, color);
+    queue.Execute();
+}
+
+void TextRenderer::RenderText(RenderQueue &queue, const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+{
+    if (this->uploaded)
+    {
+        this->vertices.clear();
+        this->uploaded = false;
+    }
+    this->layout(text.c_str(), nullptr);
+    this->appendQuads(this->vertices, x, y, scale, color, this->ranges);
+    // One draw per page, the first string drawn uploads them all
+    for (const TextRange &range : this->ranges)
+    {
+        GLint first = range.First;
+        GLsizei count = range.Count;
+        queue.Submit(RENDER_LAYER_HUD, this->TextShader.ID, range.Texture, this->VAO, BLEND_ALPHA, [this, first, count]() {
+            if (!this->uploaded)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+                glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(GLfloat), this->vertices.data(), GL_STREAM_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                this->uploaded = true;
+            }
+            glDrawArrays(GL_TRIANGLES, first, count);
+        });
+    }
+}
+
+TextHandle TextRenderer::CreateText()
+{
+    TextMesh mesh;
+    glGenBuffers(1, &mesh.VBO);
+    mesh.VAO = this->makeVertexArray(mesh.VBO);
+    mesh.Capacity = 0;
+    mesh.Built = false;
+    mesh.X = mesh.Y = mesh.Scale = 0.0f;
+    mesh.Color = glm::vec3(0.0f);
+    this->meshes.push_back(mesh);
+    return static_cast<TextHandle>(this->meshes.size() - 1);
+}
+
+void TextRenderer::SetText(TextHandle handle, const char *text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+{
+    TextMesh &mesh = this->meshes[handle];
+    if (mesh.Built && mesh.Text == text && mesh.X == x && mesh.Y == y && mesh.Scale == scale && mesh.Color == color)
+        return;
+    // Assigning reuses the string's storage once it has grown to the longest text
+    mesh.Text = text;
+    mesh.X = x;
+    mesh.Y = y;
+    mesh.Scale = scale;
+    mesh.Color = color;
+    this->buildMesh(mesh);
+}
+
+void TextRenderer::buildMesh(TextMesh &mesh)
+{
+    this->layout(mesh.Text.c_str(), &mesh.Slots);
+    mesh.Built = true;
+    this->meshVertices.clear();
+    this->appendQuads(this->meshVertices, mesh.X, mesh.Y, mesh.Scale, mesh.Color, mesh.Ranges);
+    GLsizeiptr size = this->meshVertices.size() * sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    if (size > mesh.Capacity)
+    {
+        glBufferData(GL_ARRAY_BUFFER, size, this->meshVertices.data(), GL_DYNAMIC_DRAW);
+        mesh.Capacity = size;
+    }
+    else if (size > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, this->meshVertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TextRenderer::RenderText(RenderQueue &queue, TextHandle handle)
+{
+    TextMesh &mesh = this->meshes[handle];
+    // Only rebuilt if one of its own glyphs left the atlas
+    bool current = mesh.Built;
+    for (size_t i = 0; current && i < mesh.Slots.size(); ++i)
+        current = this->slots[mesh.Slots[i].Slot].Generation == mesh.Slots[i].Generation;
+    if (!current)
+        this->buildMesh(mesh);
+    else
+        for (const SlotUse &use : mesh.Slots)
+            this->slots[use.Slot].LastUsed = this->frame;
+    for (const TextRange &range : mesh.Ranges)
+    {
+        GLint first = range.First;
+        GLsizei count = range.Count;
+        queue.Submit(RENDER_LAYER_HUD, this->TextShader.ID, range.Texture, mesh.VAO, BLEND_ALPHA, [first, count]() {
+            glDrawArrays(GL_TRIANGLES, first, count);
+        });
+    }
+}
+
+void TextRenderer::layout(const char *text, std::vector<SlotUse> *usedSlots)
+{
+    this->line.clear();
+    if (usedSlots != nullptr)
+        usedSlots->clear();
+    for (const char *c = text; *c != '\0';)
+    {
+        const Glyph *glyph = this->lookup(decodeUtf8(c));
+        if (glyph == nullptr)
+            continue; // No room left in the atlas this frame
+        this->line.push_back(&glyph->Metrics);
+        if (usedSlots != nullptr && glyph->Slot >= 0)
+        {
+            SlotUse use = {glyph->Slot, this->slots[glyph->Slot].Generation};
+            usedSlots->push_back(use);
+        }
+    }
+}
+
+void TextRenderer::appendQuads(std::vector<GLfloat> &out, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<TextRange> &ranges)
+{
+    // Pages of the line, in order of appearance
+    ranges.clear();
+    for (const Character *ch : this->line)
+    {
+        if (ch->Texture == 0)
+            continue; // Blanks only move the cursor
+        bool seen = false;
+        for (const TextRange &range : ranges)
+            seen = seen || range.Texture == ch->Texture;
+        if (!seen)
+        {
+            TextRange range = {ch->Texture, 0, 0};
+            ranges.push_back(range);
+        }
+    }
+    for (TextRange &range : ranges)
+    {
+        range.First = static_cast<GLint>(out.size() / TEXT_VERTEX_FLOATS);
+        GLfloat penX = x;
+        // Iterate through all characters
+        for (const Character *ch : this->line)
+        {
+            // Now advance cursors for next glyph
+            GLfloat xpos = penX + ch->Bearing.x * scale;
+            penX += (ch->Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+            if (ch->Texture != range.Texture)
+                continue;
+            GLfloat ypos = y + (this->top - ch->Bearing.y) * scale;
+
+            GLfloat w = ch->Size.x * scale;
+            GLfloat h = ch->Size.y * scale;
+            const glm::vec4 &uv = ch->UV;
+            GLfloat quad[6][TEXT_VERTEX_FLOATS] = {
+                {xpos, ypos + h, uv.x, uv.w, color.r, color.g, color.b},
+                {xpos + w, ypos, uv.z, uv.y, color.r, color.g, color.b},
+                {xpos, ypos, uv.x, uv.y, color.r, color.g, color.b},
+
+                {xpos, ypos + h, uv.x, uv.w, color.r, color.g, color.b},
+                {xpos + w, ypos + h, uv.z, uv.w, color.r, color.g, color.b},
+                {xpos + w, ypos, uv.z, uv.y, color.r, color.g, color.b}};
+            out.insert(out.end(), &quad[0][0], &quad[0][0] + 6 * TEXT_VERTEX_FLOATS);
+        }
+        range.Count = static_cast<GLsizei>(out.size() / TEXT_VERTEX_FLOATS) - range.First;
+    }
+}
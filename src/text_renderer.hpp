@@ -1,35 +1,186 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include "texture.hpp"
 #include "shader.hpp"
+#include "render_queue.hpp"
+#include "thread_pool.hpp"
+
+// Glyphs are rasterized SDF_UPSCALE times larger than their atlas size, and
+// their distance fields reach SDF_SPREAD atlas pixels past the outline
+const int SDF_UPSCALE = 4;
+const int SDF_SPREAD = 4;
+
+// Atlas pages are split in square cells, one glyph each. Pages are created as
+// glyphs come in, and once TEXT_MAX_PAGES are full the least recently drawn
+// glyph makes room: video memory stays bounded whatever the text.
+const GLuint TEXT_PAGE_SIZE = 512;
+const GLuint TEXT_MAX_PAGES = 4;
 
 struct Character
 {
-    GLuint TextureID;   // ID handle of the glyph texture
-    glm::ivec2 Size;    // Size of glyph
-    glm::ivec2 Bearing; // Offset from baseline to left/top of glyph
+    glm::vec2 Size;     // Size of glyph (its distance field)
+    glm::vec2 Bearing;  // Offset from baseline to left/top of glyph
     GLuint Advance;     // Horizontal offset to advance to next glyph
+    glm::vec4 UV;       // Top left (x, y) and bottom right (z, w) of the glyph in its page
+    GLuint Texture;     // Atlas page of the glyph, 0 for blanks
 };
 
+// Where the glyphs come from
+struct TextRendererStats
+{
+    unsigned long Rasterized; // Glyphs rendered by FreeType while drawing
+    unsigned long Preloaded;  // Glyphs rendered ahead by the worker
+    unsigned long Evicted;    // Glyphs dropped from the atlas to make room
+
+    TextRendererStats() : Rasterized(0), Preloaded(0), Evicted(0) {}
+};
+
+// Retained text, see TextRenderer::CreateText
+typedef unsigned int TextHandle;
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+// Text is UTF-8. Glyphs are rasterized the first time they are drawn (or
+// ahead of time by a worker thread, see Preload) into atlas pages of signed
+// distance fields, which stay sharp at any scale. A string is one draw per
+// page it uses, usually just one. The printable ASCII glyphs are cached on
+// disk next to the font (keyed by the font's hash and the size): once the
+// cache exists, plain ASCII text never needs FreeType.
 class TextRenderer
 {
   public:
-    std::map<GLchar, Character> Characters;
+    std::vector<Texture2D> Pages;
     Shader TextShader;
     
-    TextRenderer(GLuint width, GLuint height);
+    TextRenderer();
+    ~TextRenderer();
     
     void Load(std::string font, GLuint fontSize);
-    void RenderText(std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color = glm::vec3(1.0f));
+    // Rasterize the glyphs of text on the worker thread, so drawing it later
+    // doesn't stall on FreeType
+    void Preload(const std::string &text);
+    // Glyphs drawn since the last call are never evicted, so call this once
+    // per frame before queueing text. Also picks up the preloaded glyphs.
+    void BeginFrame();
+    // Draws right away. It doesn't start a frame: glyphs of text queued
+    // earlier would become evictable before their queue runs, so BeginFrame
+    // stays up to the caller.
+    void RenderText(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color = glm::vec3(1.0f));
+    // Queue the string in the HUD layer. The quads of every string queued
+    // until the next execution share one vertex buffer upload.
+    void RenderText(RenderQueue &queue, const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color = glm::vec3(1.0f));
+
+    // Retained text for strings that rarely change: each handle keeps its
+    // mesh in its own buffer. SetText only rebuilds it when the string or its
+    // placement differ from last time (or its glyphs moved), and queueing it
+    // touches no vertices.
+    TextHandle CreateText();
+    void SetText(TextHandle handle, const char *text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color = glm::vec3(1.0f));
+    void RenderText(RenderQueue &queue, TextHandle handle);
+
+    const TextRendererStats &Stats() const { return this->stats; }
 
   private:
+    // A rasterized glyph before it goes to the atlas
+    struct GlyphBitmap
+    {
+        uint32_t Codepoint;
+        glm::vec2 Size, Bearing;
+        GLuint Advance;
+        std::vector<unsigned char> Field;
+    };
+    struct Glyph
+    {
+        Character Metrics;
+        int Slot; // Atlas cell, -1 for blanks
+    };
+    struct Slot
+    {
+        uint32_t Codepoint;
+        unsigned long LastUsed;   // Frame the glyph was last drawn in
+        unsigned long Generation; // Bumped whenever the cell gets a new glyph
+    };
+    // A cell a retained mesh reads, and which glyph it held then
+    struct SlotUse
+    {
+        int Slot;
+        unsigned long Generation;
+    };
+    // Vertices of one page in a retained mesh
+    struct TextRange
+    {
+        GLuint Texture;
+        GLint First;
+        GLsizei Count;
+    };
+    struct TextMesh
+    {
+        GLuint VAO, VBO;
+        GLsizeiptr Capacity; // Bytes allocated in VBO
+        std::vector<TextRange> Ranges;
+        std::vector<SlotUse> Slots; // Cells of its glyphs, stamped whenever it is drawn
+        bool Built;
+        std::string Text;
+        GLfloat X, Y, Scale;
+        glm::vec3 Color;
+    };
+
     GLuint VAO, VBO;
+    std::vector<TextMesh> meshes;
+    std::vector<GLfloat> meshVertices; // Scratch space for mesh rebuilds
+    GLfloat top;                   // Bearing of 'H': the top of a line
+    std::vector<GLfloat> vertices; // Glyph quads queued for the next execution
+    bool uploaded;                 // Quads are in the VBO, the next queued string starts over
+
+    // Font
+    std::string fontData; // FreeType reads the face from it
+    GLuint fontSize;
+    FT_LibraryRec_ *library;
+    FT_FaceRec_ *face;
+    std::mutex faceLock; // The worker shares the face
+    GLuint cellSize;
+    // Atlas
+    std::unordered_map<uint32_t, Glyph> glyphs; // Glyphs in the atlas, and blanks
+    Glyph *latinGlyphs[256];                    // The ones below 256 in glyphs, found without hashing; null if absent
+    std::vector<Slot> slots;
+    std::vector<unsigned char> cell; // Scratch space for uploads
+    unsigned long frame;
+    TextRendererStats stats;
+    std::vector<const Character *> line; // Glyphs of the string being laid out
+    std::vector<TextRange> ranges;
+    // Rasterized glyphs waiting for the atlas: the cached ASCII ones stay
+    // around, the preloaded ones come from the worker
+    std::unordered_map<uint32_t, GlyphBitmap> stored;
+    std::unordered_set<uint32_t> requested;
+    std::mutex readyLock;
+    std::vector<GlyphBitmap> ready;
+    ThreadPool worker;
+
+    void openFace();
+    void closeFace();
+    bool rasterize(uint32_t codepoint, GlyphBitmap &glyph);
+    const Glyph *lookup(uint32_t codepoint);
+    const Glyph *place(const GlyphBitmap &bitmap);
+    int allocateSlot();
+    void collect();
+    bool loadCache(const std::string &file, uint64_t fontHash);
+    void saveCache(const std::string &file, uint64_t fontHash, const std::vector<GlyphBitmap> &bitmaps) const;
+    void layout(const char *text, std::vector<SlotUse> *usedSlots);
+    void appendQuads(std::vector<GLfloat> &out, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<TextRange> &ranges);
+    void buildMesh(TextMesh &mesh);
+    GLuint makeVertexArray(GLuint vbo) const;
 };
 
-#endif
\ No newline at end of file
+#endif
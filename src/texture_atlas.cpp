@@ -0,0 +1,34 @@
+#include "texture_atlas.hpp"
+
+ShelfPacker::ShelfPacker(GLuint width, GLuint height, GLuint padding)
+    : width(width), height(height), padding(padding), shelfX(0), shelfY(0), shelfHeight(0)
+{
+}
+
+bool ShelfPacker::Pack(GLuint width, GLuint height, GLuint &x, GLuint &y)
+{
+    GLuint paddedWidth = width + 2 * this->padding;
+    GLuint paddedHeight = height + 2 * this->padding;
+    if (paddedWidth > this->width)
+        return false;
+    if (this->shelfX + paddedWidth > this->width)
+    {
+        // Shelf is full, open the next one
+        this->shelfY += this->shelfHeight;
+        this->shelfX = 0;
+        this->shelfHeight = 0;
+    }
+    if (this->shelfY + paddedHeight > this->height)
+        return false;
+    x = this->shelfX + this->padding;
+    y = this->shelfY + this->padding;
+    this->shelfX += paddedWidth;
+    if (paddedHeight > this->shelfHeight)
+        this->shelfHeight = paddedHeight;
+    return true;
+}
+
+void ShelfPacker::Reset()
+{
+    this->shelfX = this->shelfY = this->shelfHeight = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Side of the square atlas textures
+const GLuint ATLAS_PAGE_SIZE = 1024;
+// Border around every image: its edge pixels repeated, so linear filtering
+// never picks up a neighbour
+const GLuint ATLAS_PADDING = 1;
+
+// Where an image ended up in an atlas
+struct AtlasRegion
+{
+    GLuint Texture;       // Atlas page (GL texture) holding the image, 0 if none
+    glm::vec4 UV;         // Top left (x, y) and bottom right (z, w) texture coordinates
+    GLuint Width, Height; // Size in pixels
+
+    AtlasRegion() : Texture(0), UV(0.0f, 0.0f, 1.0f, 1.0f), Width(0), Height(0) {}
+};
+
+// Shelf packer: rectangles are placed left to right on a shelf as tall as the
+// tallest of them, and a new shelf opens below when one is full. Packing in
+// order of decreasing height keeps the wasted space small.
+class ShelfPacker
+{
+  public:
+    ShelfPacker(GLuint width, GLuint height, GLuint padding = ATLAS_PADDING);
+
+    // Position (inside the padding) of a width x height rectangle, false if
+    // it doesn't fit anymore
+    bool Pack(GLuint width, GLuint height, GLuint &x, GLuint &y);
+    void Reset();
+
+  private:
+    GLuint width, height, padding;
+    GLuint shelfX, shelfY, shelfHeight;
+};
+
+#endif
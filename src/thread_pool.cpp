@@ -0,0 +1,106 @@
+#include "thread_pool.hpp"
+
+// Pool worker running on this thread, to keep nested submits local
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local unsigned int currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : queued(0), pending(0), nextQueue(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned int i = 0; i < threads; ++i)
+        this->queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    for (unsigned int i = 0; i < threads; ++i)
+        this->workers.push_back(std::thread(&ThreadPool::run, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (size_t i = 0; i < this->workers.size(); ++i)
+        this->workers[i].join();
+}
+
+void ThreadPool::Submit(const std::function<void()> &task)
+{
+    unsigned int index;
+    if (currentPool == this)
+        index = currentWorker;
+    else
+        index = this->nextQueue++ % this->queues.size();
+    this->pending++;
+    {
+        // Counted under the pool lock so a worker about to sleep can't miss
+        // it, and before the push so a worker popping it right away can't
+        // take the count below zero
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(this->queues[index]->Lock);
+        this->queues[index]->Tasks.push_back(task);
+    }
+    this->wake.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->idle.wait(guard, [this] { return this->pending == 0; });
+}
+
+bool ThreadPool::pop(unsigned int index, std::function<void()> &task)
+{
+    // Own deque first (LIFO, cache friendly), then steal the oldest task of another worker
+    for (size_t i = 0; i < this->queues.size(); ++i)
+    {
+        TaskQueue &queue = *this->queues[(index + i) % this->queues.size()];
+        std::lock_guard<std::mutex> guard(queue.Lock);
+        if (queue.Tasks.empty())
+            continue;
+        if (i == 0)
+        {
+            task = std::move(queue.Tasks.back());
+            queue.Tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.Tasks.front());
+            queue.Tasks.pop_front();
+        }
+        this->queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(unsigned int index)
+{
+    currentPool = this;
+    currentWorker = index;
+    for (;;)
+    {
+        std::function<void()> task;
+        if (this->pop(index, task))
+        {
+            task();
+            if (--this->pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(this->lock);
+                this->idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->wake.wait(guard, [this] { return this->stopping || this->queued > 0; });
+        if (this->stopping && this->queued == 0)
+            return;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a task deque: it pops its own
+// work from the back and, when empty, steals from the front of the others,
+// so uneven task lengths (short and long matches) still keep all cores busy.
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(unsigned int threads = 0); // 0: one worker per hardware thread
+    ~ThreadPool();
+
+    void Submit(const std::function<void()> &task);
+    // Blocks until every submitted task has finished. Never call it from a
+    // task of the same pool: it would wait for that task too, and deadlock.
+    void Wait();
+    unsigned int Size() const { return static_cast<unsigned int>(this->workers.size()); }
+
+  private:
+    struct TaskQueue
+    {
+        std::mutex Lock;
+        std::deque<std::function<void()> > Tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue> > queues;
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake, idle;
+    std::atomic<unsigned int> queued;  // Tasks waiting in any deque
+    std::atomic<unsigned int> pending; // Tasks queued or running
+    std::atomic<unsigned int> nextQueue;
+    bool stopping;
+
+    void run(unsigned int index);
+    bool pop(unsigned int index, std::function<void()> &task);
+};
+
+#endif
\ No newline at end of file
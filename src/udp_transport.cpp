@@ -0,0 +1,161 @@
+#include "udp_transport.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static void writeUint32(unsigned char *bytes, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static uint32_t readUint32(const unsigned char *bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    return value;
+}
+
+UdpTransport::UdpTransport()
+    : handle(-1), remoteAddress(0), remotePort(0)
+{
+#ifdef _WIN32
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+}
+
+UdpTransport::~UdpTransport()
+{
+    this->close();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool UdpTransport::Host(unsigned short port)
+{
+    this->remotePort = 0;
+    return this->open(port);
+}
+
+bool UdpTransport::Join(const std::string &host, unsigned short port)
+{
+    addrinfo hints = addrinfo();
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+    {
+        std::cout << "ERROR::NETPLAY: Failed to resolve " << host << std::endl;
+        return false;
+    }
+    this->remoteAddress = reinterpret_cast<sockaddr_in *>(result->ai_addr)->sin_addr.s_addr;
+    this->remotePort = htons(port);
+    freeaddrinfo(result);
+    return this->open(0);
+}
+
+bool UdpTransport::open(unsigned short port)
+{
+    this->close();
+    this->handle = static_cast<intptr_t>(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (this->handle < 0)
+    {
+        std::cout << "ERROR::NETPLAY: Failed to create a socket" << std::endl;
+        this->handle = -1;
+        return false;
+    }
+    sockaddr_in local = sockaddr_in();
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(this->handle, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0)
+    {
+        std::cout << "ERROR::NETPLAY: Failed to bind port " << port << std::endl;
+        this->close();
+        return false;
+    }
+    // Never block the frame: Receive just reports that nothing arrived
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(this->handle, FIONBIO, &nonBlocking);
+#else
+    fcntl(this->handle, F_SETFL, fcntl(this->handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    return true;
+}
+
+void UdpTransport::close()
+{
+    if (this->handle < 0)
+        return;
+#ifdef _WIN32
+    closesocket(this->handle);
+#else
+    ::close(this->handle);
+#endif
+    this->handle = -1;
+}
+
+void UdpTransport::Send(const InputPacket &packet)
+{
+    if (this->handle < 0 || this->remotePort == 0)
+        return;
+    unsigned char bytes[INPUT_PACKET_BYTES];
+    writeUint32(bytes, packet.Ack);
+    writeUint32(bytes + 4, packet.FirstTick);
+    writeUint32(bytes + 8, packet.Count);
+    std::memcpy(bytes + 12, packet.Buttons, MAX_ROLLBACK_TICKS);
+    sockaddr_in remote = sockaddr_in();
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = this->remoteAddress;
+    remote.sin_port = this->remotePort;
+    sendto(this->handle, reinterpret_cast<const char *>(bytes), sizeof(bytes), 0, reinterpret_cast<sockaddr *>(&remote), sizeof(remote));
+}
+
+bool UdpTransport::Receive(InputPacket &packet)
+{
+    if (this->handle < 0)
+        return false;
+    unsigned char bytes[INPUT_PACKET_BYTES];
+    for (;;)
+    {
+        sockaddr_in sender = sockaddr_in();
+        socklen_t senderSize = sizeof(sender);
+        int size = recvfrom(this->handle, reinterpret_cast<char *>(bytes), sizeof(bytes), 0, reinterpret_cast<sockaddr *>(&sender), &senderSize);
+        if (size < 0)
+            return false; // Nothing left (or an error, which is just as unreliable)
+        if (size != static_cast<int>(INPUT_PACKET_BYTES))
+            continue;
+        if (this->remotePort == 0)
+        {
+            // First packet to a host, its sender is the peer from now on
+            this->remoteAddress = sender.sin_addr.s_addr;
+            this->remotePort = sender.sin_port;
+        }
+        else if (sender.sin_addr.s_addr != this->remoteAddress || sender.sin_port != this->remotePort)
+            continue;
+        packet.Ack = readUint32(bytes);
+        packet.FirstTick = readUint32(bytes + 4);
+        packet.Count = readUint32(bytes + 8);
+        if (packet.Count > MAX_ROLLBACK_TICKS)
+            continue;
+        std::memcpy(packet.Buttons, bytes + 12, MAX_ROLLBACK_TICKS);
+        return true;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <cstdint>
+#include <string>
+
+#include "rollback.hpp"
+
+// Size of an InputPacket on the wire: Ack, FirstTick and Count as little
+// endian 32-bit integers, then the buttons
+const unsigned int INPUT_PACKET_BYTES = 12 + MAX_ROLLBACK_TICKS;
+
+// Transport over a non-blocking IPv4 UDP socket. Only packets from the peer
+// are taken; a host doesn't know its peer until the first packet arrives, so
+// it drops what it sends before that (the session resends it anyway).
+class UdpTransport : public Transport
+{
+  public:
+    UdpTransport();
+    ~UdpTransport();
+
+    // Waits for a peer on the given port
+    bool Host(unsigned short port);
+    // Talks to a host, from any free local port
+    bool Join(const std::string &host, unsigned short port);
+
+    void Send(const InputPacket &packet);
+    bool Receive(InputPacket &packet);
+
+  private:
+    intptr_t handle;         // Socket, -1 if none
+    uint32_t remoteAddress;  // Network byte order
+    uint16_t remotePort;     // Network byte order, 0 until the peer is known
+
+    bool open(unsigned short port);
+    void close();
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "ai_controller.hpp"
+#include "random.hpp"
+#include "simulation.hpp"
+
+// Micro-benchmark of the computer player: decisions per second for random
+// ball states, with re-planning forced on every call.
+//
+// Usage: pong_ai_bench [--decisions N]
+
+int main(int argc, char *argv[])
+{
+    unsigned int decisions = 10000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--decisions") == 0 && i + 1 < argc)
+            decisions = std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--decisions N]" << std::endl;
+            return -1;
+        }
+    }
+
+    // A pool of random situations, so the benchmark isn't just one cached branch
+    const unsigned int STATES = 1024;
+    Random random(42);
+    std::vector<Simulation> states(STATES, Simulation(800, 600));
+    for (unsigned int i = 0; i < STATES; ++i)
+    {
+        states[i].State = GAME_ACTIVE;
+        states[i].Ball.Position = Vec2(random.Range(40.0f, 740.0f), random.Range(0.0f, 580.0f));
+        states[i].Ball.Velocity = Vec2(random.Range(-900.0f, 900.0f), random.Range(-900.0f, 900.0f));
+        states[i].Paddle1.Position.y = random.Range(0.0f, 500.0f);
+        states[i].Paddle2.Position.y = random.Range(0.0f, 500.0f);
+    }
+
+    AiController left(PADDLE_LEFT, 0.0f, 20.0f);
+    AiController right(PADDLE_RIGHT, 0.0f, 20.0f);
+    const float deltaTime = 1.0f / 120.0f;
+    unsigned int checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < decisions; i += 2)
+    {
+        const Simulation &state = states[(i / 2) % STATES];
+        checksum += left.Decide(state, deltaTime) | right.Decide(state, deltaTime);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "decisions:      " << decisions << " (checksum " << checksum << ")" << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "decisions/sec:  " << (elapsed.count() > 0.0 ? decisions / elapsed.count() : 0.0) << std::endl;
+    std::cout << "ns/decision:    " << (decisions > 0 ? elapsed.count() * 1e9 / decisions : 0.0) << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "ai_controller.hpp"
+#include "arena.hpp"
+#include "ball_kernel.hpp"
+#include "particle_pool.hpp"
+#include "replay.hpp"
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+// Runs complete matches without a window or GL context, as fast as the CPU allows,
+// and reports the raw simulation throughput.
+//
+// Usage: pong_headless [--matches N] [--tick-rate HZ] [--max-ticks N] [--arena BALLS] [--particles N]
+//                      [--threads N] [--verify-kernels] [--record FILE] [--replay FILE] [--hash-log FILE]
+//
+// With --arena the multi-ball stress mode runs for --max-ticks ticks instead.
+// --particles times PARTICLE_TICKS updates of an emitter kept full with N particles,
+// on --threads workers (0: one per hardware thread) when given. The checksum of
+// the final particles is the same whatever the thread count.
+// --verify-kernels cross-checks the SIMD ball kernels against the scalar reference.
+// --record writes the first match to a replay file; --replay re-simulates a
+// replay as fixed workload and checks that every keyframe is reproduced.
+// The state hash of every tick of the first match is folded into a trace hash;
+// --hash-log also writes them one per line, to diff runs of different machines
+// or numeric modes (PONG_FIXED_POINT) and find the first tick that diverged.
+
+const unsigned int ARENA_WIDTH = 800;
+const unsigned int ARENA_HEIGHT = 600;
+const unsigned int PARTICLE_TICKS = 1000;
+
+int runArena(unsigned int balls, float tickRate, unsigned long long ticks)
+{
+    float deltaTime = 1.0f / tickRate;
+    Simulation match(ARENA_WIDTH, ARENA_HEIGHT);
+    Arena arena(ARENA_WIDTH, ARENA_HEIGHT);
+    arena.Spawn(balls);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long long t = 0; t < ticks; ++t)
+        arena.Update(deltaTime, match.Paddle1, match.Paddle2);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "kernel:         " << BallKernelName(SelectBallKernel()) << std::endl;
+    std::cout << "balls:          " << arena.Count() << " (score " << arena.Paddle1Score << ":" << arena.Paddle2Score << ")" << std::endl;
+    std::cout << "ticks:          " << ticks << " @ " << tickRate << " Hz" << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "ticks/sec:      " << (elapsed.count() > 0.0 ? ticks / elapsed.count() : 0.0) << std::endl;
+    std::cout << "ball ticks/sec: " << (elapsed.count() > 0.0 ? ticks * arena.Count() / elapsed.count() : 0.0) << std::endl;
+    return 0;
+}
+
+int runParticles(unsigned int particles, float tickRate, int threads)
+{
+    float deltaTime = 1.0f / tickRate;
+    ParticlePool pool(particles);
+    std::unique_ptr<ThreadPool> workers;
+    if (threads >= 0)
+    {
+        workers.reset(new ThreadPool(threads));
+        pool.Workers = workers.get();
+    }
+    // Particles are visible for 0.4 s: spawning a tick's share of the pool keeps it full
+    unsigned int spawns = static_cast<unsigned int>(particles * deltaTime / 0.4f) + 1;
+    while (pool.Count() < particles)
+        pool.Spawn(spawns, glm::vec2(400.0f, 300.0f), glm::vec2(45.0f, 30.0f));
+    pool.ResetStats();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < PARTICLE_TICKS; ++t)
+    {
+        pool.Spawn(spawns, glm::vec2(400.0f, 300.0f), glm::vec2(45.0f, 30.0f));
+        pool.Update(deltaTime);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const ParticlePoolStats &stats = pool.Stats();
+    std::cout << "particles:      " << pool.Count() << " live of " << pool.Capacity() << " (peak " << stats.Peak << ")" << std::endl;
+    std::cout << "spawned:        " << stats.Spawned << " (" << stats.Dropped << " dropped, pool full)" << std::endl;
+    std::cout << "threads:        " << (workers ? workers->Size() : 0) << std::endl;
+    std::cout << "ticks:          " << PARTICLE_TICKS << " @ " << tickRate << " Hz" << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "update:         " << elapsed.count() * 1e6 / PARTICLE_TICKS << " us/tick" << std::endl;
+    uint64_t checksum = 14695981039346656037ull;
+    const std::vector<float> *streams[] = {&pool.PositionX, &pool.PositionY, &pool.Brightness, &pool.Alpha, &pool.Life};
+    for (const std::vector<float> *stream : streams)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(stream->data());
+        for (size_t i = 0; i < pool.Count() * sizeof(float); ++i)
+            checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+    }
+    std::cout << "checksum:       " << std::hex << checksum << std::dec << std::endl;
+    return 0;
+}
+
+int runReplay(const char *file)
+{
+    ReplayReader replay;
+    if (!replay.Open(file))
+        return -1;
+    const ReplayHeader &header = replay.Header();
+    Simulation match(header.Width, header.Height);
+    uint32_t particleSeed = 0;
+    replay.Seek(0, match, particleSeed);
+
+    unsigned int mismatches = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < header.TickCount; ++tick)
+    {
+        if (tick % header.KeyframeInterval == 0)
+        {
+            ReplayKeyframe expected = replay.Keyframe(tick / header.KeyframeInterval);
+            ReplayKeyframe actual = CaptureKeyframe(tick, match, expected.ParticleSeed);
+            if (std::memcmp(&expected, &actual, sizeof(expected)) != 0)
+                mismatches++;
+        }
+        match.ProcessInput(replay.Input(tick), header.TickLength);
+        match.Update(header.TickLength);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "ticks:          " << header.TickCount << " @ " << 1.0f / header.TickLength << " Hz" << std::endl;
+    std::cout << "keyframes:      " << replay.KeyframeCount() << " (" << mismatches << " mismatches)" << std::endl;
+    std::cout << "final score:    " << match.Paddle1Score << ":" << match.Paddle2Score << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "ticks/sec:      " << (elapsed.count() > 0.0 ? header.TickCount / elapsed.count() : 0.0) << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int matches = 100;
+    float tickRate = 120.0f;
+    unsigned long long maxTicks = 1000000;
+    unsigned int arenaBalls = 0;
+    unsigned int particles = 0;
+    int threads = -1;
+    const char *recordFile = nullptr;
+    const char *hashFile = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--matches") == 0 && i + 1 < argc)
+            matches = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            tickRate = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc)
+            maxTicks = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--arena") == 0 && i + 1 < argc)
+            arenaBalls = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+            particles = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc)
+            hashFile = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            return runReplay(argv[++i]);
+        else if (std::strcmp(argv[i], "--verify-kernels") == 0)
+        {
+            bool success = VerifyBallKernels(10007, 1) && VerifyBallKernels(3, 2);
+            std::cout << "ball kernels:   " << (success ? "OK" : "MISMATCH") << std::endl;
+            return success ? 0 : 1;
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--matches N] [--tick-rate HZ] [--max-ticks N] [--arena BALLS] [--particles N] [--threads N] [--verify-kernels] [--record FILE] [--replay FILE] [--hash-log FILE]" << std::endl;
+            return -1;
+        }
+    }
+    if (tickRate <= 0.0f)
+    {
+        std::cout << "ERROR::HEADLESS: Tick rate must be positive" << std::endl;
+        return -1;
+    }
+    if (arenaBalls > 0)
+        return runArena(arenaBalls, tickRate, maxTicks);
+    if (particles > 0)
+        return runParticles(particles, tickRate, threads);
+
+    float deltaTime = 1.0f / tickRate;
+    unsigned long long totalTicks = 0;
+    unsigned int paddle1Wins = 0, paddle2Wins = 0, unfinished = 0;
+
+    ReplayWriter recorder;
+    if (recordFile != nullptr && !recorder.Open(recordFile, ARENA_WIDTH, ARENA_HEIGHT, deltaTime))
+        return -1;
+    std::ofstream hashLog;
+    if (hashFile != nullptr)
+    {
+        hashLog.open(hashFile, std::ios::trunc);
+        if (!hashLog)
+        {
+            std::cout << "ERROR::HEADLESS: Failed to open " << hashFile << std::endl;
+            return -1;
+        }
+    }
+    uint64_t trace = 14695981039346656037ull;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int m = 0; m < matches; ++m)
+    {
+        Simulation match(ARENA_WIDTH, ARENA_HEIGHT);
+        unsigned int buttons = INPUT_START;
+        unsigned long long ticks = 0;
+        do
+        {
+            if (m == 0)
+                recorder.Record(match, 0, buttons);
+            match.ProcessInput(buttons, deltaTime);
+            match.Update(deltaTime);
+            buttons = TrackBall(match);
+            if (m == 0)
+            {
+                uint64_t hash = match.Hash();
+                trace = (trace ^ hash) * 1099511628211ull;
+                if (hashLog)
+                    hashLog << ticks << " " << std::hex << hash << std::dec << "\n";
+            }
+            ++ticks;
+        } while (match.State == GAME_ACTIVE && ticks < maxTicks);
+        recorder.Close();
+        totalTicks += ticks;
+        if (match.State != GAME_WIN)
+            unfinished++;
+        else if (match.Paddle1Score > match.Paddle2Score)
+            paddle1Wins++;
+        else
+            paddle2Wins++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "numeric mode:   " << NUMERIC_MODE_NAME << std::endl;
+    std::cout << "matches:        " << matches << " (" << paddle1Wins << " / " << paddle2Wins
+              << ", " << unfinished << " unfinished)" << std::endl;
+    std::cout << "ticks:          " << totalTicks << " @ " << tickRate << " Hz" << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "ticks/sec:      " << (elapsed.count() > 0.0 ? totalTicks / elapsed.count() : 0.0) << std::endl;
+    std::cout << "trace hash:     " << std::hex << trace << std::dec << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "ai_controller.hpp"
+#include "rollback.hpp"
+#include "simulation.hpp"
+
+// Plays one match between two rollback sessions connected by the in-process
+// loopback network, each driven by its own computer player, and checks that
+// both peers end up with identical states for every confirmed tick.
+//
+// Usage: pong_netplay_loopback [--ticks N] [--latency TICKS] [--jitter TICKS] [--loss P] [--seed N]
+
+const unsigned int COURT_WIDTH = 800;
+const unsigned int COURT_HEIGHT = 600;
+
+int main(int argc, char *argv[])
+{
+    unsigned int ticks = 20000;
+    unsigned int latency = 4, jitter = 2;
+    float loss = 0.05f;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+            latency = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--jitter") == 0 && i + 1 < argc)
+            jitter = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--loss") == 0 && i + 1 < argc)
+            loss = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--ticks N] [--latency TICKS] [--jitter TICKS] [--loss P] [--seed N]" << std::endl;
+            return -1;
+        }
+    }
+
+    const float tickLength = 1.0f / 60.0f;
+    LoopbackNetwork network(latency, jitter, loss, seed);
+    Simulation initial(COURT_WIDTH, COURT_HEIGHT);
+    RollbackSession left(initial, PADDLE_LEFT, network.Endpoint(0), tickLength);
+    RollbackSession right(initial, PADDLE_RIGHT, network.Endpoint(1), tickLength);
+    // Wide aiming error so points are actually scored and the match restarts
+    AiController leftBot(PADDLE_LEFT, 0.1f, 80.0f, seed + 1);
+    AiController rightBot(PADDLE_RIGHT, 0.1f, 80.0f, seed + 2);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int frame = 0; left.Tick < ticks || right.Tick < ticks; ++frame)
+    {
+        network.Advance();
+        // Each bot only sees its own peer's (possibly predicted) state
+        unsigned int leftButtons = leftBot.Decide(left.State(), tickLength);
+        unsigned int rightButtons = rightBot.Decide(right.State(), tickLength);
+        if (left.State().State != GAME_ACTIVE)
+            leftButtons |= INPUT_START;
+        if (left.Tick < ticks)
+            left.AdvanceFrame(leftButtons);
+        if (right.Tick < ticks)
+            right.AdvanceFrame(rightButtons);
+        if (frame > ticks * 100)
+        {
+            std::cout << "ERROR::NETPLAY: Peers stopped making progress" << std::endl;
+            return 1;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t compared = std::min(left.ConfirmedHashes.size(), right.ConfirmedHashes.size());
+    size_t mismatches = 0;
+    for (size_t t = 0; t < compared; ++t)
+        if (left.ConfirmedHashes[t] != right.ConfirmedHashes[t])
+            mismatches++;
+
+    // Cost of one save + restore, which bounds how cheap a rollback can be
+    const unsigned int COPIES = 1000000;
+    Simulation scratch = left.State();
+    Simulation saved = scratch;
+    std::chrono::steady_clock::time_point copyStart = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < COPIES; ++i)
+    {
+        saved = scratch;
+        scratch = saved;
+        scratch.Ball.Position.x = -scratch.Ball.Position.x; // Keep the copies observable
+    }
+    std::chrono::duration<double> copyElapsed = std::chrono::steady_clock::now() - copyStart;
+
+    std::cout << "network:        " << latency << " ticks latency, " << jitter << " jitter, " << loss * 100.0f << "% loss ("
+              << network.Dropped << " of " << network.Sent << " packets dropped)" << std::endl;
+    std::cout << "ticks:          " << left.Tick << " / " << right.Tick << std::endl;
+    std::cout << "score:          " << left.State().Paddle1Score << ":" << left.State().Paddle2Score << std::endl;
+    std::cout << "rollbacks:      " << left.Rollbacks << " / " << right.Rollbacks << " ("
+              << left.ResimulatedTicks << " / " << right.ResimulatedTicks << " ticks simulated again)" << std::endl;
+    std::cout << "stalls:         " << left.Stalls << " / " << right.Stalls << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "save+restore:   " << copyElapsed.count() * 1e9 / COPIES << " ns (" << ToFloat(scratch.Ball.Position.x) << ")" << std::endl;
+    std::cout << "confirmed:      " << compared << " ticks, " << mismatches << " mismatches" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "ai_controller.hpp"
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+// Runs many independent bot-vs-bot matches in parallel on a work-stealing
+// thread pool and reports throughput and rally statistics.
+//
+// Usage: pong_tournament [--matches N] [--threads N] [--tick-rate HZ] [--seed N] [--max-ticks N]
+//                        [--reaction SECONDS] [--error PIXELS]
+
+const unsigned int COURT_WIDTH = 800;
+const unsigned int COURT_HEIGHT = 600;
+
+struct MatchResult
+{
+    unsigned long long Ticks;
+    int Paddle1Score, Paddle2Score;
+    unsigned int Points;       // Points played
+    unsigned int PaddleHits;   // Over all rallies
+    unsigned int LongestRally; // In paddle hits
+    bool Finished;
+};
+
+struct BotSettings
+{
+    float ReactionDelay;
+    float Error;
+};
+
+MatchResult playMatch(uint32_t seed, float deltaTime, unsigned long long maxTicks, BotSettings bots)
+{
+    MatchResult result = MatchResult();
+    // The rules serve the same way every time, matches differ through the bots' seeds
+    Simulation match(COURT_WIDTH, COURT_HEIGHT);
+    AiController left(PADDLE_LEFT, bots.ReactionDelay, bots.Error, seed ^ 0x9E3779B9u);
+    AiController right(PADDLE_RIGHT, bots.ReactionDelay, bots.Error, seed ^ 0x7F4A7C15u);
+    unsigned int buttons = INPUT_START;
+    unsigned int rally = 0;
+    do
+    {
+        match.ProcessInput(buttons, deltaTime);
+        unsigned int events = match.Update(deltaTime);
+        if (events & EVENT_PADDLE_HIT)
+        {
+            rally++;
+            result.PaddleHits++;
+        }
+        if (events & (EVENT_PLAYER1_SCORED | EVENT_PLAYER2_SCORED))
+        {
+            result.Points++;
+            result.LongestRally = std::max(result.LongestRally, rally);
+            rally = 0;
+        }
+        buttons = left.Decide(match, deltaTime) | right.Decide(match, deltaTime);
+        result.Ticks++;
+    } while (match.State == GAME_ACTIVE && result.Ticks < maxTicks);
+    result.Paddle1Score = match.Paddle1Score;
+    result.Paddle2Score = match.Paddle2Score;
+    result.Finished = match.State == GAME_WIN;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int matches = 10000;
+    unsigned int threads = 0;
+    float tickRate = 120.0f;
+    uint32_t seed = 1;
+    unsigned long long maxTicks = 1000000;
+    BotSettings bots = {0.15f, 80.0f}; // Error wide enough for bots to miss now and then
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--matches") == 0 && i + 1 < argc)
+            matches = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            tickRate = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc)
+            maxTicks = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--reaction") == 0 && i + 1 < argc)
+            bots.ReactionDelay = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--error") == 0 && i + 1 < argc)
+            bots.Error = std::strtof(argv[++i], nullptr);
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--matches N] [--threads N] [--tick-rate HZ] [--seed N] [--max-ticks N] [--reaction SECONDS] [--error PIXELS]" << std::endl;
+            return -1;
+        }
+    }
+    if (tickRate <= 0.0f)
+    {
+        std::cout << "ERROR::TOURNAMENT: Tick rate must be positive" << std::endl;
+        return -1;
+    }
+
+    float deltaTime = 1.0f / tickRate;
+    // Every match writes only its own slot, no synchronization needed
+    std::vector<MatchResult> results(matches);
+    ThreadPool pool(threads);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned int m = 0; m < matches; ++m)
+    {
+        MatchResult *result = &results[m];
+        uint32_t matchSeed = seed + m * 2654435761u; // Spread consecutive seeds apart
+        pool.Submit([result, matchSeed, deltaTime, maxTicks, bots] { *result = playMatch(matchSeed, deltaTime, maxTicks, bots); });
+    }
+    pool.Wait();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    unsigned long long ticks = 0, points = 0, hits = 0;
+    unsigned int paddle1Wins = 0, paddle2Wins = 0, unfinished = 0, longestRally = 0;
+    for (unsigned int m = 0; m < matches; ++m)
+    {
+        const MatchResult &result = results[m];
+        ticks += result.Ticks;
+        points += result.Points;
+        hits += result.PaddleHits;
+        longestRally = std::max(longestRally, result.LongestRally);
+        if (!result.Finished)
+            unfinished++;
+        else if (result.Paddle1Score > result.Paddle2Score)
+            paddle1Wins++;
+        else
+            paddle2Wins++;
+    }
+
+    double seconds = elapsed.count() > 0.0 ? elapsed.count() : 1e-9;
+    std::cout << "threads:        " << pool.Size() << std::endl;
+    std::cout << "matches:        " << matches << " (" << paddle1Wins << " / " << paddle2Wins
+              << ", " << unfinished << " unfinished)" << std::endl;
+    std::cout << "elapsed:        " << elapsed.count() << " s" << std::endl;
+    std::cout << "matches/sec:    " << matches / seconds << std::endl;
+    std::cout << "ticks/sec:      " << ticks / seconds << std::endl;
+    std::cout << "points:         " << points << std::endl;
+    std::cout << "avg rally:      " << (points > 0 ? static_cast<double>(hits) / points : 0.0) << " hits" << std::endl;
+    std::cout << "longest rally:  " << longestRally << " hits" << std::endl;
+    return 0;
+}
\ No newline at end of file